@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <type_traits>
+
+// Native byte order encoding for checkpoints. Values are copied as-is,
+// strings and arrays are prefixed with a 32-bit length.
+class BinaryWriter {
+public:
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "put() needs a trivially copyable type");
+        append(&value, sizeof(T));
+    }
+
+    void putString(std::string_view text) {
+        put(static_cast<uint32_t>(text.size()));
+        append(text.data(), text.size());
+    }
+
+    template <typename T>
+    void putArray(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "putArray() needs a trivially copyable type");
+        put(static_cast<uint32_t>(values.size()));
+        append(values.data(), values.size() * sizeof(T));
+    }
+
+    void reserve(size_t bytes) { buffer.reserve(bytes); }
+    void clear() { buffer.clear(); } // keeps the capacity, for reuse as a chunk
+    size_t size() const { return buffer.size(); }
+    const std::vector<char>& data() const { return buffer; }
+    std::vector<char> release() { return std::move(buffer); }
+
+private:
+    std::vector<char> buffer;
+
+    void append(const void* src, size_t bytes) {
+        const char* p = static_cast<const char*>(src);
+        buffer.insert(buffer.end(), p, p + bytes);
+    }
+};
+
+// Reads what BinaryWriter wrote. A failed read (truncated or corrupt input)
+// is sticky: every later read also fails, so callers check ok() once.
+class BinaryReader {
+public:
+    BinaryReader(const char* data, size_t size) : data(data), size(size) {}
+
+    template <typename T>
+    bool get(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "get() needs a trivially copyable type");
+        return take(&value, sizeof(T));
+    }
+
+    bool getString(std::string& text) {
+        uint32_t length = 0;
+        if (!get(length) || !fits(length)) return false;
+        text.assign(data + pos, length);
+        pos += length;
+        return true;
+    }
+
+    template <typename T>
+    bool getArray(std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "getArray() needs a trivially copyable type");
+        uint32_t count = 0;
+        if (!get(count) || !fits(static_cast<size_t>(count) * sizeof(T))) return false;
+        values.resize(count);
+        return take(values.data(), count * sizeof(T));
+    }
+
+    bool ok() const { return !failed; }
+    bool atEnd() const { return pos == size; }
+    size_t remaining() const { return size - pos; }
+
+private:
+    const char* data;
+    size_t size;
+    size_t pos = 0;
+    bool failed = false;
+
+    bool fits(size_t bytes) {
+        if (failed || bytes > size - pos) failed = true;
+        return !failed;
+    }
+
+    bool take(void* out, size_t bytes) {
+        if (!fits(bytes)) return false;
+        if (bytes > 0) std::memcpy(out, data + pos, bytes);
+        pos += bytes;
+        return true;
+    }
+};
@@ -0,0 +1,50 @@
+#include "Config.h"
+#include <fstream>
+#include "MemoryManager.h"
+
+bool Config::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::string key;
+    while (file >> key) {
+        readKey(key, file);
+    }
+    workload.validate();
+    return true;
+}
+
+bool Config::readKey(const std::string& key, std::istream& in) {
+    if (key == "num-cpu") in >> numCPU;
+    else if (key == "scheduler") in >> schedulerAlgo;
+    else if (key == "quantum-cycles") in >> quantumCycles;
+    else if (key == "batch-process-freq") in >> batchProcessFreq;
+    else if (key == "min-ins") in >> minInstructions;
+    else if (key == "max-ins") in >> maxInstructions;
+    else if (key == "delay-per-exec") in >> delayPerExec;
+    else if (key == "max-overall-mem") in >> maxOverallMem;
+    else if (key == "min-mem-per-proc") in >> minMemPerProc;
+    else if (key == "max-mem-per-proc") in >> maxMemPerProc;
+    else if (key == "backing-store") in >> backingStore;
+    else if (key == "swap-prefetch") in >> swapPrefetch;
+    else if (key == "control-socket") in >> controlSocket;
+    else return workload.readKey(key, in);
+    return true;
+}
+
+std::string Config::check() const {
+    if (numCPU < 1 || numCPU > MAX_CPU) return "num-cpu must be 1-" + std::to_string(MAX_CPU);
+    if (schedulerAlgo != "fcfs" && schedulerAlgo != "rr") return "scheduler must be fcfs or rr";
+    if (quantumCycles < 1) return "quantum-cycles must be at least 1";
+    if (batchProcessFreq < 1) return "batch-process-freq must be at least 1";
+    if (minInstructions < 1 || maxInstructions < minInstructions) return "need 1 <= min-ins <= max-ins";
+    if (delayPerExec < 0) return "delay-per-exec must not be negative";
+    // 0 turns admission control off; anything else needs one whole block
+    if (maxOverallMem < 0 || (maxOverallMem > 0 && static_cast<size_t>(maxOverallMem) < MemoryManager::MIN_BLOCK))
+        return "max-overall-mem must be 0 or at least " + std::to_string(MemoryManager::MIN_BLOCK);
+    if (minMemPerProc < 1 || maxMemPerProc < minMemPerProc) return "need 1 <= min-mem-per-proc <= max-mem-per-proc";
+    // Generated sizes are capped to the usable memory, but the smallest must fit
+    if (maxOverallMem > 0 && static_cast<size_t>(minMemPerProc) > MemoryManager::usableSize(maxOverallMem))
+        return "min-mem-per-proc exceeds the usable part of max-overall-mem";
+    return "";
+}
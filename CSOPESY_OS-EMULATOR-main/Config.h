@@ -0,0 +1,32 @@
+#pragma once
+#include <istream>
+#include <string>
+#include "Workload.h"
+
+// Settings from config.txt. One emulator instance runs off one copy.
+struct Config {
+    static constexpr int MAX_CPU = 128;
+
+    int numCPU = 1;
+    std::string schedulerAlgo = "fcfs";
+    int quantumCycles = 3;
+    int batchProcessFreq = 1;
+    int minInstructions = 5;
+    int maxInstructions = 10;
+    int delayPerExec = 0;
+    int maxOverallMem = 16384;
+    int minMemPerProc = 64;
+    int maxMemPerProc = 4096;
+    std::string backingStore = "csopesy-backing-store.bin"; // "none" disables swapping
+    int swapPrefetch = 2;
+    std::string controlSocket = "csopesy.sock"; // "none" disables the control socket
+    Workload workload;
+
+    bool load(const std::string& path); // false if the file cannot be opened
+
+    // Reads the value of one key; false if the key is unknown
+    bool readKey(const std::string& key, std::istream& in);
+
+    // Settings the emulator cannot run with; empty if the config is usable
+    std::string check() const;
+};
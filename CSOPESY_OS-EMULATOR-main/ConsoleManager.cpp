@@ -1,6 +1,5 @@
 #include "ConsoleManager.h"
-#include "Instruction.h"
-#include "InstructionsTypes.h"
+#include "ProgramParser.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -8,9 +7,25 @@
 #include <chrono>
 #include <cstdlib>
 #include <random>
-
-
-const int cpuCycleTicks = 100; //constant ticks ng CPU
+#include <charconv>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <new>
+#include "MappedFile.h"
+#include "Report.h"
+
+
+const int cpuCycleTicks = Emulator::TICK_MILLISECONDS; //constant ticks ng CPU
+const size_t traceCapacity = 65536;
+const std::chrono::milliseconds snapshotAge(500);
+const std::chrono::seconds logInterestAge(5);
+const size_t maxLogInterest = 1024;
+const size_t maxTraceCapacity = size_t(1) << 24;
+const size_t maxTraceEvents = size_t(1) << 24; // all tracks together, 384 MiB
+const uint64_t defaultSweepTicks = 2000;
+const size_t maxSweepJobs = 4096;
 ConsoleManager* ConsoleManager::instance = nullptr;
 
 ConsoleManager* ConsoleManager::getInstance() {
@@ -43,20 +58,40 @@ void headerprnt() {
 void Option1() {
     std::cout << "\nOptions:" << std::endl;
     std::cout << "- initialize" << std::endl;
+    std::cout << "- restore [file]" << std::endl;
     std::cout << "- exit" << std::endl;
 }
 
 void Option2() {
     std::cout << "\nOptions:" << std::endl;
     std::cout << "- screen -ls" << std::endl;
-    std::cout << "- screen -s [process name]" << std::endl;
+    std::cout << "- screen -s [process name] [memsize]" << std::endl;
     std::cout << "- screen -r [process name]" << std::endl;
+    std::cout << "- screen -c [process name] [memsize] \"[instructions]\"" << std::endl;
     std::cout << "- scheduler-start" << std::endl;
     std::cout << "- scheduler-stop" << std::endl;
-    std::cout << "- report-util" << std::endl;
+    std::cout << "- report-util [txt|csv|bin] [file]" << std::endl;
+    std::cout << "- vmstat" << std::endl;
+    std::cout << "- set-cpu [core count]" << std::endl;
+    std::cout << "- trace-start [events per core]" << std::endl;
+    std::cout << "- trace-stop [file]" << std::endl;
+    std::cout << "- sweep [key=v1,v2,...]... [ticks=n] [runs=n]" << std::endl;
+    std::cout << "- checkpoint [file]" << std::endl;
+    std::cout << "- restore [file]" << std::endl;
     std::cout << "- exit" << std::endl;
 }
 
+// One sweep override on a copy of the config; seeds come from runs, every
+// instance gets its own backing store and none prefetches, so those keys
+// are not swept
+bool applySetting(Config& config, const std::string& key, const std::string& value) {
+    if (key == "seed" || key == "backing-store" || key == "control-socket" || key == "swap-prefetch") return false;
+    std::istringstream in(value);
+    if (!config.readKey(key, in) || in.fail()) return false;
+    in >> std::ws;
+    return in.eof();
+}
+
 void ConsoleManager::run() {
     std::string input;
     headerprnt();
@@ -67,9 +102,16 @@ void ConsoleManager::run() {
         std::cout << "\nRoot:\\> ";
         std::getline(std::cin, input);
 
-        if (input == "exit") break;
+        if (input == "exit") {
+            if (ticking) stopScheduler();
+            if (checkpointThread.joinable()) checkpointThread.join();
+            if (reportThread.joinable()) reportThread.join();
+            controlServer.reset();
+            engine.reset(); // the singleton is never destroyed; this removes the backing store
+            break;
+        }
 
-        if (!isInitialized && input != "initialize") {
+        if (!isInitialized && input != "initialize" && input.rfind("restore ", 0) != 0) {
             std::cout << "Please initialize the system first using `initialize` command.\n";
             continue;
         }
@@ -79,17 +121,38 @@ void ConsoleManager::run() {
         } else if (input == "screen -ls") {
             listScreens();
         } else if (input.rfind("screen -s ", 0) == 0) {
-            std::string name = input.substr(10);
-            screenAttach(name);
+            std::string args = input.substr(10);
+            size_t space = args.find(' ');
+            std::string name = args.substr(0, space);
+            int memorySize = 0;
+            if (space == std::string::npos || parseMemorySize(std::string_view(args).substr(space + 1), memorySize)) {
+                screenAttach(name, memorySize);
+            }
         } else if (input.rfind("screen -r ", 0) == 0) {
             std::string name = input.substr(10);
             screenReattach(name);
+        } else if (input.rfind("screen -c ", 0) == 0) {
+            screenCreate(std::string_view(input).substr(10));
         } else if (input == "scheduler-start") {
             startScheduler();
         } else if (input == "scheduler-stop") {
             stopScheduler();
-        } else if (input == "report-util") {
-            generateReport();
+        } else if (input == "report-util" || input.rfind("report-util ", 0) == 0) {
+            generateReport(input.size() > 12 ? input.substr(12) : "");
+        } else if (input == "vmstat") {
+            vmstat();
+        } else if (input.rfind("set-cpu ", 0) == 0) {
+            setCoreCount(input.substr(8));
+        } else if (input == "trace-start" || input.rfind("trace-start ", 0) == 0) {
+            traceStart(input.size() > 12 ? input.substr(12) : "");
+        } else if (input.rfind("trace-stop ", 0) == 0) {
+            traceStop(input.substr(11));
+        } else if (input.rfind("sweep ", 0) == 0) {
+            sweep(input.substr(6));
+        } else if (input.rfind("checkpoint ", 0) == 0) {
+            checkpoint(input.substr(11));
+        } else if (input.rfind("restore ", 0) == 0) {
+            restore(input.substr(8));
         } else {
             std::cout << "Unknown command.\n";
         }
@@ -98,54 +161,91 @@ void ConsoleManager::run() {
 }
 
 void ConsoleManager::initialize() {
+    if (ticking) {
+        std::cout << "Stop the scheduler before initializing again.\n";
+        return;
+    }
+
+    // The tick and generator threads are stopped, but the control socket
+    // thread and the report thread may still read the engine
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (engine && !engine->getProcesses().empty()) {
+        std::cout << "Already initialized with " << engine->getProcesses().size()
+                  << " processes; use restore to replace them, or exit and start again.\n";
+        return;
+    }
     loadConfig();
+    std::string problem = config.check();
+    if (!problem.empty()) {
+        std::cout << "Cannot initialize with this config.txt: " << problem << ".\n";
+        return;
+    }
+    engine = std::make_unique<Emulator>(config);
+    std::atomic_store(&snapshot, std::shared_ptr<const Emulator::Snapshot>()); // of the old engine
+    engine->setTracer(tracer.get());
+    seedEngine();
+    setupControlSocket();
     isInitialized = true;
     std::cout << "System initialized successfully.\n";
 }
 
 void ConsoleManager::printConfig() const {
+    const Config& current = engine ? engine->getConfig() : config;
     std::cout << "=== Current Configuration ===\n";
-    std::cout << "Number of CPUs: " << numCPU << "\n";
-    std::cout << "Quantum Cycles: " << quantumCycles << "\n";
-    std::cout << "Batch Process Frequency: " << batchProcessFreq << "seconds\n";
-    std::cout << "Instruction Range: " << minInstructions << " - " << maxInstructions << "\n";
-    std::cout << "Delay per Execution: " << delayPerExec << "ms\n"; 
+    std::cout << "Number of CPUs: " << current.numCPU << "\n";
+    std::cout << "Quantum Cycles: " << current.quantumCycles << "\n";
+    std::cout << "Batch Process Frequency: " << current.batchProcessFreq << "seconds\n";
+    std::cout << "Instruction Range: " << current.minInstructions << " - " << current.maxInstructions << "\n";
+    std::cout << "Delay per Execution: " << current.delayPerExec << "ms\n"; 
+    std::cout << "Memory: " << current.maxOverallMem << " bytes, " << current.minMemPerProc << " - " << current.maxMemPerProc << " per process\n";
 }
 
 void ConsoleManager::loadConfig() {
-    std::ifstream file("config.txt");
-    if (!file.is_open()) {
+    config = Config();
+    if (!config.load("config.txt")) {
         std::cout << "Failed to open config.txt. Using defaults.\n";
         return;
     }
 
-    std::string key;
-    while (file >> key) {
-        if (key == "num-cpu") file >> numCPU;
-        else if (key == "scheduler") file >> schedulerAlgo;
-        else if (key == "quantum-cycles") file >> quantumCycles;
-        else if (key == "batch-process-freq") file >> batchProcessFreq;
-        else if (key == "min-ins") file >> minInstructions;
-        else if (key == "max-ins") file >> maxInstructions;
-        else if (key == "delay-per-exec") file >> delayPerExec;
+    std::cout << "Config loaded: " << config.numCPU << " CPUs, Scheduler = " << config.schedulerAlgo
+              << ", Quantum = " << config.quantumCycles << ", Min/Max Instructions = "
+              << config.minInstructions << "/" << config.maxInstructions << ", Delay = " << config.delayPerExec
+              << ", Memory = " << config.maxOverallMem << " (" << config.minMemPerProc << "-" << config.maxMemPerProc << " per process)\n";
+    std::cout << "Workload: " << config.workload.describe() << "\n";
+}
+
+// seed 0 in config.txt asks for a random seed, printed so the run can be repeated
+uint64_t ConsoleManager::pickSeed() const {
+    uint64_t seed = config.workload.getSeed();
+    if (seed == 0) {
+        std::random_device device;
+        seed = (static_cast<uint64_t>(device()) << 32) | device();
     }
+    return seed;
+}
 
-    std::cout << "Config loaded: " << numCPU << " CPUs, Scheduler = " << schedulerAlgo
-              << ", Quantum = " << quantumCycles << ", Min/Max Instructions = "
-              << minInstructions << "/" << maxInstructions << ", Delay = " << delayPerExec << "\n";
+void ConsoleManager::seedEngine() {
+    engine->setSeed(pickSeed());
+    std::cout << "Workload seed: " << engine->getSeed() << "\n";
 }
 
 void ConsoleManager::startScheduler() {
+    if (ticking) {
+        std::cout << "Scheduler is already running.\n";
+        return;
+    }
     std::cout << "Starting process generation...\n";
 
-    scheduler = std::make_unique<Scheduler>(numCPU, schedulerAlgo, quantumCycles);
-    // For simulation
-    for (int i = 0; i < batchProcessFreq; ++i) {
-        std::string procName = "p" + std::to_string(currentPID + 1);
-
-        int instCount = minInstructions + (rand() % (maxInstructions - minInstructions + 1));
-        createProcess(procName, instCount, true);
-        scheduler->addProcess(allProcesses.back());
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        // Keep a stopped or restored scheduler so its queue and cores survive
+        Scheduler& scheduler = engine->startScheduler();
+        // For simulation
+        for (int i = 0; i < engine->getConfig().batchProcessFreq; ++i) {
+            auto proc = engine->generateProcess(engine->nextProcessName(), false);
+            std::cout << "Process " << proc->getName() << " created with " << proc->getLinesOfCode() << " instructions.\n";
+            scheduler.addProcess(proc);
+        }
     }
 
     //start ticking
@@ -154,43 +254,33 @@ void ConsoleManager::startScheduler() {
     //thick thread
     schedulerThread = std::thread([this](){
         while (ticking){
-            scheduler->tick();
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                engine->getScheduler()->tick();
+                if (snapshotWanted) publishSnapshot();
+            }
             std::this_thread::sleep_for(std::chrono::milliseconds(cpuCycleTicks));
         }
 
     });
 
     //make processes in the background
-    std::thread([this](){
+    generatorThread = std::thread([this, batchProcessFreq = engine->getConfig().batchProcessFreq](){
         while(ticking){
-            std::this_thread::sleep_for(std::chrono::seconds(batchProcessFreq));
+            {
+                std::unique_lock<std::mutex> wait(stopMutex);
+                if (stopSignal.wait_for(wait, std::chrono::seconds(batchProcessFreq), [this] { return !ticking; })) {
+                    break;
+                }
+            }
 
             // Generate a new dummy process
-            std::string procName = "p" + std::to_string(++currentPID);
-            int instCount = minInstructions + (rand() % (maxInstructions - minInstructions + 1));
-            createProcess(procName, instCount, false);
-            scheduler->addProcess(allProcesses.back());
-
-            //std::cout << "Auto-created process: " << procName << " with " << instCount << " instructions\n";
+            std::lock_guard<std::mutex> lock(stateMutex);
+            engine->schedule(engine->generateProcess(engine->nextProcessName(), false));
         }
 
-    }).detach();
-
-    // // create scheduler
-    // scheduler = std::make_unique<Scheduler>(numCPU, schedulerAlgo, quantumCycles);
-    // for(const auto& proc : allProcesses){
-    //     scheduler->addProcess(proc);
-    // }
-
-    // //ticking thread
-    // ticking = true;
-    // schedulerThread = std::thread([this]() {
-    //     while (ticking) {
-    //     //    std::cout << "[TICK]\n";
-    //         scheduler->tick();
-    //         std::this_thread::sleep_for(std::chrono::milliseconds(delayPerExec));
-    //     }
-    // });
+    });
+
     std::cout<<"Scheduler started\n"; 
 
 }
@@ -202,131 +292,355 @@ void ConsoleManager::stopScheduler() {
     }
 
     std::cout << "Stopping scheduler...\n";
-    ticking = false;
+    {
+        std::lock_guard<std::mutex> wait(stopMutex);
+        ticking = false;
+    }
+    stopSignal.notify_all();
 
     if (schedulerThread.joinable()) {
         schedulerThread.join();
     }
+    if (generatorThread.joinable()) {
+        generatorThread.join();
+    }
 
     std::cout << "Scheduler stopped.\n";
 }
 
-void ConsoleManager::createProcess(const std::string& name, int instructionCount, bool silent) {
-   auto proc = std::make_shared<Process>(++currentPID, name, instructionCount);
+// set-cpu <n>: resize the simulated CPU while the scheduler keeps ticking
+void ConsoleManager::setCoreCount(const std::string& arg) {
+    int count = 0;
+    auto parsed = std::from_chars(arg.data(), arg.data() + arg.size(), count);
+    if (parsed.ec != std::errc() || parsed.ptr != arg.data() + arg.size() || count < 1 || count > Config::MAX_CPU) {
+        std::cout << "Usage: set-cpu <1-" << Config::MAX_CPU << ">\n";
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    int previous = engine->getConfig().numCPU;
+    engine->setNumCores(count);
+    std::cout << "CPU resized from " << previous << " to " << count << " cores.\n";
+}
 
-    // Generate dummy instructions
-    std::vector<std::shared_ptr<Instruction>> insts;
-    for (int i = 0; i < instructionCount; ++i) {
-        if (i % 4 == 0)
-            insts.push_back(std::make_shared<DeclareInstruction>("x", i));
-        else if (i % 4 == 1)
-            insts.push_back(std::make_shared<AddInstruction>("x", "x", "1"));
-        else if (i % 4 == 2)
-            insts.push_back(std::make_shared<SubtractInstruction>("x", "x", "1"));
-        else
-            insts.push_back(std::make_shared<PrintInstruction>("Instruction executed."));
+// trace-start [events per core]: record scheduling events from now on
+void ConsoleManager::traceStart(const std::string& arg) {
+    size_t capacity = traceCapacity;
+    if (!arg.empty()) {
+        auto parsed = std::from_chars(arg.data(), arg.data() + arg.size(), capacity);
+        if (parsed.ec != std::errc() || parsed.ptr != arg.data() + arg.size() || capacity == 0 || capacity > maxTraceCapacity) {
+            std::cout << "Usage: trace-start [events per core, 1-" << maxTraceCapacity << "]\n";
+            return;
+        }
     }
 
-    proc->setInstructions(insts);
+    // The tick thread only touches the tracer with stateMutex held, so it
+    // can be replaced here; a disabled one is never freed while in use
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (tracer && tracer->isEnabled()) {
+        std::cout << "Tracing is already on, use trace-stop <file> first.\n";
+        return;
+    }
+    int cores = engine->getConfig().numCPU;
+    // Every ring is allocated up front, one per core plus the scheduler's
+    size_t perTrack = Tracer::ringSize(capacity);
+    if (perTrack > maxTraceEvents / (cores + 1)) {
+        std::cout << "Cannot trace " << cores << " cores with " << capacity << " events each, at most "
+                  << maxTraceEvents << " events are buffered in total.\n";
+        return;
+    }
+    try {
+        tracer = std::make_unique<Tracer>(cores, capacity);
+    } catch (const std::bad_alloc&) {
+        std::cout << "Not enough memory for " << perTrack * (cores + 1) << " trace events.\n";
+        return;
+    }
+    tracer->setEnabled(true);
+    engine->setTracer(tracer.get());
+    std::cout << "Tracing " << cores << " cores, up to " << capacity << " events per core.\n";
+}
 
-    processTable[name] = proc;
-    allProcesses.push_back(proc);
-    if(silent){
-        std::cout << "Process " << name << " created with " << instructionCount << " instructions.\n";
+// trace-stop <file>: write the recorded events as Chrome/Perfetto trace JSON
+void ConsoleManager::traceStop(const std::string& path) {
+    if (!tracer || !tracer->isEnabled()) {
+        std::cout << "Tracing is not on, use trace-start first.\n";
+        return;
+    }
+    tracer->setEnabled(false);
+
+    // Draining is lock-free, only the process names need the state lock
+    std::vector<Tracer::Event> events;
+    tracer->drain(events);
+    std::unordered_map<int, std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        for (const auto& proc : engine->getProcesses()) {
+            names[proc->getPID()] = proc->getName();
+        }
+    }
+
+    bool saved = Tracer::writeJson(path, tracer->getCoreTracks(), events, [&names](int pid) {
+        auto it = names.find(pid);
+        return it == names.end() ? "pid " + std::to_string(pid) : it->second;
+    });
+    if (!saved) {
+        std::cout << "Failed to write trace to " << path << ".\n";
+        return;
     }
+    std::cout << "Trace saved to " << path << " (" << events.size() << " events, "
+              << tracer->getDropped() << " dropped). Open it in chrome://tracing or ui.perfetto.dev.\n";
 }
 
-//screen -ls (show ongoing and finished processes)
-void ConsoleManager::listScreens() {
-    std::cout << "=== CPU Utilization Summary ===\n";
-
-    int totalCores = numCPU;
-    int usedCores = scheduler ? (totalCores - scheduler->getAvailableCores()) : 0;
-    int availableCores = scheduler ? scheduler->getAvailableCores() : totalCores;
-
-    std::cout << "Total Cores: " << totalCores << "\n";
-    std::cout << "Used Cores: " << usedCores << "\n";
-    std::cout << "Available Cores: " << availableCores << "\n\n";
-
-
-    std::cout << "=== Currently RUNNING/READY/WAITING processes ===\n";
-    bool anyShown = false;
-    for (auto& pair : processTable) {
-        auto proc = pair.second;
-        if (!proc->isFinished()) {
-            anyShown = true;
-            std::string stateStr;
-            switch (proc->getState()) {
-                case Process::READY: stateStr = "READY"; break;
-                case Process::RUNNING: stateStr = "RUNNING"; break;
-                case Process::WAITING: stateStr = "WAITING"; break;
-                case Process::FINISHED: stateStr = "FINISHED"; break;
+// sweep key=v1,v2 ... [ticks=n] [runs=n]: every combination of the listed
+// values runs headless on its own Emulator, spread over the host's cores.
+// Run r of each combination uses seed + r, so all combinations see the same
+// workloads and the table differs only by the swept settings.
+void ConsoleManager::sweep(const std::string& args) {
+    const char* usage = "Usage: sweep key=v1,v2,... [key=...] [ticks=n] [runs=n], e.g. sweep num-cpu=1,2,4 scheduler=fcfs,rr\n";
+    uint64_t ticks = defaultSweepTicks;
+    uint64_t runs = 1;
+    std::vector<std::pair<std::string, std::vector<std::string>>> axes;
+
+    std::istringstream tokens(args);
+    std::string token;
+    while (tokens >> token) {
+        size_t equals = token.find('=');
+        if (equals == 0 || equals == std::string::npos || equals + 1 == token.size()) {
+            std::cout << usage;
+            return;
+        }
+        std::string key = token.substr(0, equals);
+        std::string values = token.substr(equals + 1);
+
+        if (key == "ticks" || key == "runs") {
+            uint64_t& count = key == "ticks" ? ticks : runs;
+            auto parsed = std::from_chars(values.data(), values.data() + values.size(), count);
+            if (parsed.ec != std::errc() || parsed.ptr != values.data() + values.size() || count == 0) {
+                std::cout << usage;
+                return;
             }
-            std::cout << "  " << proc->getName()
-                      << " (PID: " << proc->getPID()
-                      << ", Core: " << proc->getCoreID()
-                      << ", State: " << stateStr << ", Progress: "
-                      << proc->getCommandCounter() << "/" << proc->getLinesOfCode()
-                      << ")\n";
-            // std::cout << "  " << proc->getName() << " (PID: " << proc->getPID()
-            //           << ", State: " << stateStr << ")\n";
+            continue;
         }
+
+        std::vector<std::string> list;
+        std::istringstream split(values);
+        std::string value;
+        Config probe = config;
+        while (std::getline(split, value, ',')) {
+            if (!applySetting(probe, key, value)) {
+                std::cout << "Cannot sweep " << key << "=" << value << ".\n" << usage;
+                return;
+            }
+            list.push_back(value);
+        }
+        axes.emplace_back(key, std::move(list));
+    }
+    if (axes.empty()) {
+        std::cout << usage;
+        return;
     }
 
-    if (!anyShown) {
-        std::cout << "  No active processes.\n";
-    }
-    // for (auto& pair : processTable) {
-    //     if (!pair.second->isFinished()) {
-    //         std::cout << "  " << pair.first << "\n";
-    //     }
-    // }
-
-    std::cout << "\n=== Finished Processes ===\n";
-    bool anyFinished = false;
-    for (const auto& pair : processTable) {
-        auto proc = pair.second;
-        if (proc->isFinished()) {
-            anyFinished = true;
-            std::cout << "  " << proc->getName()
-                      << " (PID: " << proc->getPID()
-                      << ", Core: " << proc->getCoreID()
-                      << ", Finished at: " << proc->getFinishTimeString()
-                      << ", Total Instructions: " << proc->getLinesOfCode()
-                      << ")\n";
+    // Cartesian product, last key varying fastest
+    std::vector<Config> configs;
+    std::vector<std::vector<std::string>> labels;
+    std::vector<size_t> index(axes.size(), 0);
+    size_t combinations = 1;
+    for (const auto& axis : axes) combinations = std::min(combinations * axis.second.size(), maxSweepJobs + 1);
+    if (combinations * runs > maxSweepJobs) {
+        std::cout << "Sweep is too large, at most " << maxSweepJobs << " combinations times runs.\n";
+        return;
+    }
+    for (size_t c = 0; c < combinations; ++c) {
+        Config combination = config;
+        std::vector<std::string> label;
+        for (size_t a = 0; a < axes.size(); ++a) {
+            applySetting(combination, axes[a].first, axes[a].second[index[a]]);
+            label.push_back(axes[a].second[index[a]]);
+        }
+        combination.workload.validate();
+        std::string problem = combination.check();
+        if (!problem.empty()) {
+            std::cout << "Cannot run combination " << c + 1 << ": " << problem << ".\n";
+            return;
+        }
+        configs.push_back(std::move(combination));
+        labels.push_back(std::move(label));
+        for (size_t a = axes.size(); a-- > 0;) {
+            if (++index[a] < axes[a].second.size()) break;
+            index[a] = 0;
         }
     }
-    if (!anyFinished) {
-        std::cout << "  No finished processes yet.\n";
+
+    uint64_t seed = pickSeed();
+    size_t jobs = combinations * runs;
+    size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), jobs);
+    std::cout << "Sweeping " << combinations << " configurations x " << runs << " runs of " << ticks
+              << " ticks on " << threadCount << " threads, seed " << seed << "...\n";
+
+    // Instances share nothing (PRINT timestamps use localtime_r, not the
+    // static std::localtime buffer), so the workers only share the job counter
+    std::vector<Scheduler::Summary> results(jobs);
+    std::atomic<size_t> nextJob{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&] {
+            for (size_t job; (job = nextJob++) < jobs;) {
+                Config instance = configs[job / runs];
+                // Prefetching only saves real disk reads, so skip its thread:
+                // a job is one host thread plus its own backing-store file
+                if (instance.backingStore != "none") instance.backingStore += ".sweep" + std::to_string(job);
+                instance.swapPrefetch = 0;
+                Emulator emulator(instance);
+                emulator.setSeed(seed + job % runs);
+                emulator.runTicks(ticks);
+                results[job] = emulator.getScheduler()->getSummary();
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::vector<size_t> widths;
+    for (const auto& axis : axes) {
+        size_t width = axis.first.size();
+        for (const auto& value : axis.second) width = std::max(width, value.size());
+        widths.push_back(width + 2);
+    }
+    const char* columns[] = {"Done/1k", "CPU %", "Switches", "Wait", "Turnaround", "p90", "Response"};
+    for (size_t a = 0; a < axes.size(); ++a) std::cout << std::left << std::setw(widths[a]) << axes[a].first;
+    for (const char* column : columns) std::cout << std::right << std::setw(12) << column;
+    std::cout << "\n";
+
+    // Averaged over the runs of each combination
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t c = 0; c < combinations; ++c) {
+        double done = 0, utilization = 0, switches = 0, wait = 0, turnaround = 0, p90 = 0, response = 0;
+        for (size_t r = 0; r < runs; ++r) {
+            const auto& summary = results[c * runs + r];
+            uint64_t coreTicks = summary.busyTicks + summary.idleTicks;
+            done += summary.ticks ? 1000.0 * summary.finished / summary.ticks : 0;
+            utilization += coreTicks ? 100.0 * summary.busyTicks / coreTicks : 0;
+            switches += summary.dispatches;
+            wait += summary.meanWait;
+            turnaround += summary.meanTurnaround;
+            p90 += summary.p90Turnaround;
+            response += summary.meanResponse;
+        }
+        for (size_t a = 0; a < axes.size(); ++a) std::cout << std::left << std::setw(widths[a]) << labels[c][a];
+        for (double value : {done, utilization, switches, wait, turnaround, p90, response}) {
+            std::cout << std::right << std::setw(12) << value / runs;
+        }
+        std::cout << "\n";
     }
+    std::cout.unsetf(std::ios::floatfield | std::ios::adjustfield);
+    std::cout << "Latencies are mean ticks over finished processes. Took " << elapsed.count() << " ms.\n";
+}
+
+//screen -ls (show ongoing and finished processes)
+void ConsoleManager::listScreens() {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    engine->writeScreenList(std::cout);
 }
 
 // screen -s make process 
-void ConsoleManager::screenAttach(const std::string& name) {
-    // If process does not exist, create it
-    if (processTable.count(name) == 0) {
-        int instructionCount = minInstructions + (rand() % (maxInstructions - minInstructions + 1));
-        createProcess(name, instructionCount, true);
-
-        if (scheduler) {
-            scheduler->addProcess(processTable[name]);
-        } else {
-            std::cout << "Scheduler not started yet. Process will be idle until scheduler starts.\n";
+void ConsoleManager::screenAttach(const std::string& name, int memorySize) {
+    std::shared_ptr<Process> process;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        process = engine->findProcess(name);
+        // If process does not exist, create it
+        if (!process) {
+            process = engine->generateProcess(name, true, memorySize);
+            std::cout << "Process " << name << " created with " << process->getLinesOfCode() << " instructions.\n";
+
+            if (!engine->schedule(process)) {
+                std::cout << "Scheduler not started yet. Process will be idle until scheduler starts.\n";
+            }
         }
     }
 
-    processScreen(processTable[name]);
+    processScreen(process);
 }
 
 
-void ConsoleManager::screenReattach(const std::string& name) {
-    auto it = processTable.find(name);
-    if(it == processTable.end()){
-        std::cout << "Process \"" << name << "\" does not exist.\n";
+bool ConsoleManager::parseMemorySize(std::string_view text, int& memorySize) const {
+    auto parsed = std::from_chars(text.data(), text.data() + text.size(), memorySize);
+    if (parsed.ec != std::errc() || parsed.ptr != text.data() + text.size() || memorySize <= 0) {
+        std::cout << "Invalid memory size \"" << text << "\".\n";
+        return false;
+    }
+    // The allocator rounds max-overall-mem down to a power of two
+    size_t usable = engine->getUsableMemory();
+    if (static_cast<size_t>(memorySize) > usable) {
+        std::cout << "Memory size " << memorySize << " exceeds the " << usable << " usable bytes of memory.\n";
+        return false;
+    }
+    return true;
+}
+
+// screen -c <name> <memsize> "<instructions>"
+void ConsoleManager::screenCreate(std::string_view args) {
+    auto nextWord = [&args]() {
+        size_t start = args.find_first_not_of(' ');
+        if (start == std::string_view::npos) {
+            args = std::string_view();
+            return std::string_view();
+        }
+        size_t end = args.find(' ', start);
+        std::string_view word = args.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+        args = (end == std::string_view::npos) ? std::string_view() : args.substr(end);
+        return word;
+    };
+
+    std::string_view name = nextWord();
+    std::string_view memArg = nextWord();
+    size_t start = args.find_first_not_of(' ');
+    std::string_view script = (start == std::string_view::npos) ? std::string_view() : args.substr(start);
+    if (script.size() >= 2 && script.front() == '"' && script.back() == '"') {
+        script = script.substr(1, script.size() - 2);
+    }
+
+    if (name.empty() || memArg.empty() || script.empty()) {
+        std::cout << "Usage: screen -c <process name> <memsize> \"<instructions>\"\n";
         return;
     }
+    int memorySize = 0;
+    if (!parseMemorySize(memArg, memorySize)) return;
 
-    processScreen(it->second);
+    std::string error;
+    auto program = ProgramCache::getInstance()->get(script, error);
+    if (!program) {
+        std::cout << "Invalid instructions: " << error << "\n";
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (engine->findProcess(std::string(name))) {
+        std::cout << "Process \"" << name << "\" already exists.\n";
+        return;
+    }
+
+    auto proc = engine->createProcess(std::string(name), program, memorySize);
+    std::cout << "Process " << name << " created with " << proc->getLinesOfCode() << " instructions.\n";
+
+    if (!engine->schedule(proc)) {
+        std::cout << "Scheduler not started yet. Process will be idle until scheduler starts.\n";
+    }
+}
+
+void ConsoleManager::screenReattach(const std::string& name) {
+    std::shared_ptr<Process> process;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        process = engine->findProcess(name);
+        if(!process){
+            std::cout << "Process \"" << name << "\" does not exist.\n";
+            return;
+        }
+    }
+
+    processScreen(process);
 }
 
 void ConsoleManager::processScreen(std::shared_ptr<Process> process) {
@@ -337,41 +651,273 @@ void ConsoleManager::processScreen(std::shared_ptr<Process> process) {
 
         if (input == "exit") break;
         else if (input == "process-smi") {
-            std::cout << "Name: " << process->getName() << "\n";
-            std::cout << "PID: " << process->getPID() << "\n";
-            std::cout << "Progress: " << process->getCommandCounter() << " / " << process->getLinesOfCode() << "\n";
-            std::cout << "Core ID: " << process->getCoreID() << "\n";
-            std::cout << "Logs: " << process->getOutput() << "\n";
-            if (process->isFinished()) {
-                std::cout << "Finished at: " << process->getFinishTimeString() << "\n";
-            }
+            std::lock_guard<std::mutex> lock(stateMutex);
+            Emulator::writeProcessSmi(std::cout, *process);
         } else {
             std::cout << "Unknown screen command.\n";
         }
     }
 }
 
-void ConsoleManager::generateReport() {
-    std::ofstream outFile("csopesy-log.txt");
-    if (!outFile.is_open()) {
-        std::cout << "Failed to open report file.\n";
+// report-util [txt|csv|bin] [file]: snapshot under the lock, write in the background
+void ConsoleManager::generateReport(const std::string& args) {
+    if (reportRunning) {
+        std::cout << "Report in progress: " << reportProgress << " / " << reportTotal << " processes written.\n";
         return;
     }
+    if (reportThread.joinable()) {
+        reportThread.join();
+    }
+
+    std::istringstream parts(args);
+    std::string formatName, path, extra;
+    parts >> formatName >> path >> extra;
+    Report::Format format = Report::TEXT;
+    if (!extra.empty() || (!formatName.empty() && !Report::parseFormat(formatName, format))) {
+        std::cout << "Usage: report-util [txt|csv|bin] [file]\n";
+        return;
+    }
+    if (path.empty()) path = Report::defaultPath(format);
+
+    auto start = std::chrono::steady_clock::now();
+    auto report = std::make_shared<Report>();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        const auto& processes = engine->getProcesses();
+        report->reserve(processes.size());
+        for (const auto& proc : processes) {
+            report->add(*proc);
+        }
+        if (engine->getScheduler() && format == Report::TEXT) {
+            std::ostringstream summary;
+            engine->writeVmstat(summary);
+            report->setSummary(summary.str());
+        }
+    }
 
-    outFile << "=== CPU Utilization Report ===\n";
-    for (auto& proc : allProcesses) {
-        outFile << "Process: " << proc->getName()
-                << " PID: " << proc->getPID()
-                << " Progress: " << proc->getCommandCounter() << " / " << proc->getLinesOfCode();
-        if(proc->isFinished()){
-            outFile << " [" << proc->getFinishTimeString() << "]";
+    reportTotal = report->size();
+    reportProgress = 0;
+    reportRunning = true;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "Snapshot of " << report->size() << " processes taken in " << elapsed.count()
+              << " ms, writing " << path << " in the background.\n";
+
+    reportThread = std::thread([this, report, path, format, start]() {
+        uint64_t bytes = 0;
+        bool ok = report->write(path, format, reportProgress, bytes);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        if (ok) {
+            std::cout << "\nReport saved to " << path << " (" << report->size() << " processes, " << bytes
+                      << " bytes) in " << elapsed.count() << " ms.\n";
+        } else {
+            std::cout << "\nFailed to write report " << path << ".\n";
         }
-        outFile <<"\n";
+        reportRunning = false;
+    });
+}
+
+void ConsoleManager::vmstat() {
+    std::lock_guard<std::mutex> lock(stateMutex);
+    if (!engine->getScheduler()) {
+        std::cout << "Scheduler not started yet, no memory is allocated.\n";
+        return;
+    }
+    engine->writeVmstat(std::cout);
+}
+
+void ConsoleManager::setupControlSocket() {
+    if (controlServer || config.controlSocket == "none") return;
+    controlServer = std::make_unique<ControlServer>(config.controlSocket, [this](const std::string& query) {
+        return answerQuery(query);
+    });
+    if (!controlServer->isOpen()) {
+        std::cout << "Failed to open control socket " << config.controlSocket << " (" << controlServer->getError() << ").\n";
+        controlServer.reset();
+    }
+}
+
+// Runs on the control socket thread. Answers are formatted here from a
+// snapshot the tick thread copies between ticks, so a query never holds
+// stateMutex while the simulation runs. A snapshot is reused for a while,
+// so scrapers polling every second cost at most one copy per interval.
+std::string ConsoleManager::answerQuery(const std::string& query) {
+    if (query != "screen -ls" && query != "vmstat" && query.rfind("process-smi ", 0) != 0) {
+        return "Unknown query. Available: screen -ls, process-smi <name>, vmstat, quit";
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::string name;
+    if (query.rfind("process-smi ", 0) == 0) {
+        name = query.substr(12);
+        if (logInterest.size() >= maxLogInterest && !logInterest.count(name)) logInterest.clear();
+        logInterest[name] = now;
+    }
+    auto usable = [&name](const std::shared_ptr<const Emulator::Snapshot>& taken) {
+        return taken && (name.empty() || taken->logs.count(name));
+    };
+
+    auto current = std::atomic_load(&snapshot);
+    if (!usable(current) || now - current->takenAt >= snapshotAge) {
+        // Logs of every process asked for lately ride along, so polling
+        // several processes shares one snapshot
+        std::vector<std::string> names;
+        for (auto it = logInterest.begin(); it != logInterest.end();) {
+            if (now - it->second > logInterestAge) {
+                it = logInterest.erase(it);
+            } else {
+                names.push_back(it->first);
+                ++it;
             }
-    outFile.close();
-    std::cout << "Report saved to csopesy-log.txt.\n";
+        }
+
+        bool published = false;
+        if (ticking) {
+            std::unique_lock<std::mutex> lock(snapshotMutex);
+            snapshotLogs = names;
+            snapshotWanted = true;
+            published = snapshotPublished.wait_for(lock, std::chrono::milliseconds(4 * cpuCycleTicks),
+                                                   [this] { return !snapshotWanted; });
+            snapshotWanted = false;
+        }
+        if (published) {
+            current = std::atomic_load(&snapshot);
+        } else if (!ticking) {
+            // No simulation loop to hold up, only the shell
+            std::lock_guard<std::mutex> lock(stateMutex);
+            current = engine->takeSnapshot(names);
+            std::atomic_store(&snapshot, current);
+        }
+    }
+
+    if (!usable(current)) return "The emulator is busy, try again.";
+    return renderQuery(*current, query);
+}
+
+// Called by the tick thread with stateMutex held; copies, never formats
+void ConsoleManager::publishSnapshot() {
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        if (!snapshotWanted) return;
+        names = snapshotLogs;
+    }
+    std::shared_ptr<const Emulator::Snapshot> taken = engine->takeSnapshot(names);
+    std::atomic_store(&snapshot, taken);
+
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    snapshotWanted = false;
+    snapshotPublished.notify_all();
+}
+
+std::string ConsoleManager::renderQuery(const Emulator::Snapshot& snapshot, const std::string& query) {
+    std::ostringstream out;
+    if (query == "screen -ls") {
+        Emulator::writeScreenList(out, snapshot);
+    } else if (query == "vmstat") {
+        if (snapshot.started) {
+            Emulator::writeVmstat(out, snapshot.vmstat);
+        } else {
+            out << "Scheduler not started yet, no memory is allocated.\n";
+        }
+    } else {
+        std::string name = query.substr(12);
+        const Emulator::Snapshot::Row* row = snapshot.find(name);
+        if (!row) {
+            out << "Process \"" << name << "\" does not exist.\n";
+        } else {
+            auto log = snapshot.logs.find(name);
+            Emulator::writeProcessSmi(out, *row, log != snapshot.logs.end() ? log->second : std::string());
+        }
+    }
+    return out.str();
+}
+
+// checkpoint <file>: snapshot under the state lock, write in the background
+void ConsoleManager::checkpoint(const std::string& path) {
+    if (path.empty()) {
+        std::cout << "Usage: checkpoint <file>\n";
+        return;
+    }
+    if (checkpointThread.joinable()) {
+        checkpointThread.join(); // one checkpoint write at a time
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    BinaryWriter out;
+    size_t processCount;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        processCount = engine->getProcesses().size();
+        out.reserve(processCount * 128);
+        if (!engine->save(out)) {
+            std::cout << "Failed to read swapped-out processes from the backing store.\n";
+            return;
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "Snapshot of " << processCount << " processes taken in " << elapsed.count()
+              << " ms, writing " << path << " in the background.\n";
+
+    checkpointThread = std::thread([path, image = out.release()]() {
+        // Write to a temporary file first so a crash never leaves a torn checkpoint
+        std::string temp = path + ".tmp";
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        bool ok = file.is_open() && file.write(image.data(), image.size()).good();
+        file.close();
+        if (ok) {
+            std::remove(path.c_str());
+            ok = std::rename(temp.c_str(), path.c_str()) == 0;
+        }
+
+        if (ok) {
+            std::cout << "\nCheckpoint saved to " << path << " (" << image.size() << " bytes).\n";
+        } else {
+            std::remove(temp.c_str());
+            std::cout << "\nFailed to write checkpoint " << path << ".\n";
+        }
+    });
+}
+
+// restore <file>: replaces all processes and the scheduler with a checkpoint
+void ConsoleManager::restore(const std::string& path) {
+    if (ticking) {
+        std::cout << "Stop the scheduler before restoring a checkpoint.\n";
+        return;
+    }
+    if (checkpointThread.joinable()) {
+        checkpointThread.join();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cout << "Failed to open checkpoint " << path << ".\n";
+        return;
+    }
+    BinaryReader in(file.data(), file.size());
+    std::string error;
+    auto restored = Emulator::load(in, config, error);
+    if (!restored) {
+        std::cout << "Cannot restore " << path << ": " << error << ", nothing was restored.\n";
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(stateMutex);
+    // The old engine removes the backing store as it goes, so the new one
+    // opens it only afterwards
+    engine = std::move(restored);
+    std::atomic_store(&snapshot, std::shared_ptr<const Emulator::Snapshot>()); // of the old engine
+    engine->setupSwapping();
+    engine->setTracer(tracer.get());
+    isInitialized = true;
+    std::cout << "Workload seed: " << engine->getSeed() << " (generators resume where the checkpoint left them)\n";
+    setupControlSocket();
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "Restored " << engine->getProcesses().size() << " processes from " << path
+              << " in " << elapsed.count() << " ms.\n";
 }
 
 int ConsoleManager::getCurrentPID() const {
-    return currentPID;
+    return engine ? engine->getCurrentPID() : 0;
 }
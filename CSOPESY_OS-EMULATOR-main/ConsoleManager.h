@@ -1,13 +1,22 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <memory>
 #include <vector>
 #include "Process.h"
 #include "Scheduler.h"
+#include "Config.h"
+#include "Emulator.h"
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "BinaryIO.h"
+#include "Tracer.h"
+#include "ControlServer.h"
+#include <chrono>
 
 class ConsoleManager {
 public:
@@ -17,11 +26,18 @@ public:
     void initialize(); // Loads config and initializes the scheduler
     void startScheduler();
     void stopScheduler();
-    void createProcess(const std::string& name, int instructionCount, bool silent);
     void listScreens(); // screen -ls
-    void screenAttach(const std::string& name); // screen -s <name>
+    void screenAttach(const std::string& name, int memorySize = 0); // screen -s <name> [memsize]
     void screenReattach(const std::string& name); // screen -r <name>
-    void generateReport(); // report-util
+    void screenCreate(std::string_view args); // screen -c <name> <memsize> "<instructions>"
+    void generateReport(const std::string& args); // report-util [txt|csv|bin] [file]
+    void vmstat();
+    void setCoreCount(const std::string& arg); // set-cpu <n>
+    void traceStart(const std::string& arg); // trace-start [events per core]
+    void traceStop(const std::string& path); // trace-stop <file>
+    void sweep(const std::string& args); // sweep key=v1,v2 ... [ticks=n] [runs=n]
+    void checkpoint(const std::string& path); // checkpoint <file>
+    void restore(const std::string& path); // restore <file>
     int getCurrentPID() const;
     void printConfig() const;
 
@@ -29,25 +45,45 @@ private:
     ConsoleManager();
     static ConsoleManager* instance;
     bool isInitialized = false;
-    int currentPID = 0;
 
     //adsded
-    std::unique_ptr<Scheduler> scheduler;
+    Config config; // as read from config.txt
+    std::unique_ptr<Emulator> engine;
+    std::unique_ptr<Tracer> tracer;
     std::thread schedulerThread;
+    std::thread generatorThread;
+    std::thread checkpointThread;
+    std::thread reportThread;
+    std::atomic<bool> reportRunning{false};
+    std::atomic<size_t> reportProgress{0};
+    std::atomic<size_t> reportTotal{0};
     std::atomic<bool> ticking{false};
     //added
 
-    std::unordered_map<std::string, std::shared_ptr<Process>> processTable;
-    std::vector<std::shared_ptr<Process>> allProcesses;
+    // Guards the engine; the tick and generator threads hold it while
+    // they change state
+    mutable std::mutex stateMutex;
+    std::mutex stopMutex;
+    std::condition_variable stopSignal;
 
     void processScreen(std::shared_ptr<Process> process);
     void loadConfig();
 
-    int numCPU = 1;
-    std::string schedulerAlgo = "fcfs";
-    int quantumCycles = 3;
-    int batchProcessFreq = 1;
-    int minInstructions = 5;
-    int maxInstructions = 10;
-    int delayPerExec = 0;
+    // Control socket, see answerQuery()
+    void setupControlSocket();
+    std::string answerQuery(const std::string& query);
+    void publishSnapshot();
+    static std::string renderQuery(const Emulator::Snapshot& snapshot, const std::string& query);
+    std::unique_ptr<ControlServer> controlServer;
+    // Replaced whole, never modified; use std::atomic_load/atomic_store
+    std::shared_ptr<const Emulator::Snapshot> snapshot;
+    std::mutex snapshotMutex; // guards snapshotLogs
+    std::condition_variable snapshotPublished;
+    std::vector<std::string> snapshotLogs; // processes whose logs the next snapshot copies
+    std::atomic<bool> snapshotWanted{false};
+    // control socket thread only: when process-smi last asked for each process
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> logInterest;
+    uint64_t pickSeed() const;
+    void seedEngine();
+    bool parseMemorySize(std::string_view text, int& memorySize) const;
 };
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "ControlServer.h"
+#include <vector>
+#include <cstring>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+ControlServer::ControlServer(const std::string& path, Handler handler) : path(path), handler(std::move(handler)) {
+#ifndef _WIN32
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        error = "socket path is too long";
+        return;
+    }
+
+    // Replace a socket left behind by an earlier run, but never another kind of file
+    struct stat info;
+    if (lstat(path.c_str(), &info) == 0) {
+        if (!S_ISSOCK(info.st_mode)) {
+            error = path + " exists and is not a socket";
+            return;
+        }
+        unlink(path.c_str());
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(listenFd, 8) != 0 || pipe(wakeFds) != 0) {
+        error = std::strerror(errno);
+        if (listenFd >= 0) close(listenFd);
+        listenFd = -1;
+        return;
+    }
+    fcntl(listenFd, F_SETFL, O_NONBLOCK);
+    worker = std::thread(&ControlServer::serve, this);
+#else
+    error = "Unix-domain sockets are not supported on this platform";
+#endif
+}
+
+ControlServer::~ControlServer() {
+#ifndef _WIN32
+    if (listenFd < 0) return;
+    char wake = 0;
+    ssize_t written = write(wakeFds[1], &wake, 1);
+    (void)written; // the pipe is empty, this cannot block or fail
+    worker.join();
+    close(listenFd);
+    close(wakeFds[0]);
+    close(wakeFds[1]);
+    unlink(path.c_str());
+#endif
+}
+
+bool ControlServer::isOpen() const {
+    return listenFd >= 0;
+}
+
+const std::string& ControlServer::getError() const {
+    return error;
+}
+
+void ControlServer::serve() {
+#ifndef _WIN32
+    struct Client {
+        int fd;
+        std::string in;
+        std::string out;
+        bool closing = false; // drop once out is flushed
+    };
+    std::vector<Client> clients;
+
+    while (true) {
+        std::vector<pollfd> fds;
+        fds.push_back({wakeFds[0], POLLIN, 0});
+        fds.push_back({listenFd, static_cast<short>(clients.size() < MAX_CLIENTS ? POLLIN : 0), 0});
+        for (const auto& client : clients) {
+            fds.push_back({client.fd, static_cast<short>(client.out.empty() ? POLLIN : POLLOUT), 0});
+        }
+        if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) break;
+        if (fds[0].revents) break;
+
+        for (size_t i = 0; i < clients.size(); ++i) {
+            Client& client = clients[i];
+            short events = fds[i + 2].revents;
+            if (events & POLLOUT) {
+                ssize_t sent = send(client.fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+                if (sent > 0) {
+                    client.out.erase(0, static_cast<size_t>(sent));
+                } else if (errno != EAGAIN && errno != EINTR) {
+                    client.out.clear(); // the client went away
+                    client.closing = true;
+                }
+            } else if (events & (POLLIN | POLLHUP | POLLERR)) {
+                char buffer[1024];
+                ssize_t received = recv(client.fd, buffer, sizeof(buffer), 0);
+                if (received <= 0) {
+                    if (received == 0 || (errno != EAGAIN && errno != EINTR)) client.closing = true;
+                } else {
+                    client.in.append(buffer, static_cast<size_t>(received));
+                }
+            }
+
+            // Answer every complete line; the reply is queued and sent as the socket allows
+            size_t newline;
+            while (!client.closing && (newline = client.in.find('\n')) != std::string::npos) {
+                std::string query = client.in.substr(0, newline);
+                client.in.erase(0, newline + 1);
+                if (!query.empty() && query.back() == '\r') query.pop_back();
+                if (query == "quit") {
+                    client.closing = true;
+                    break;
+                }
+                std::string answer = handler(query);
+                if (!answer.empty() && answer.back() != '\n') answer += '\n';
+                client.out += answer + ".\n";
+            }
+            if (client.in.size() > MAX_QUERY) {
+                client.out += "Query too long.\n.\n";
+                client.closing = true;
+            }
+        }
+
+        for (size_t i = 0; i < clients.size();) {
+            if (clients[i].closing && clients[i].out.empty()) {
+                close(clients[i].fd);
+                clients.erase(clients.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+
+        if (fds[1].revents & POLLIN) {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd >= 0) {
+                fcntl(fd, F_SETFL, O_NONBLOCK);
+                clients.push_back(Client{fd, "", ""});
+            }
+        }
+    }
+
+    for (const auto& client : clients) close(client.fd);
+#endif
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+// Local control endpoint on a Unix-domain socket, served by its own thread.
+// Clients send one query per line and each answer ends with a line holding
+// a single ".". The handler runs on the server thread, one query at a time.
+// Not available on Windows, where isOpen() is always false.
+class ControlServer {
+public:
+    using Handler = std::function<std::string(const std::string& query)>;
+
+    ControlServer(const std::string& path, Handler handler);
+    ~ControlServer(); // stops the thread and removes the socket file
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    bool isOpen() const;
+    const std::string& getError() const; // why opening failed
+
+private:
+    static constexpr size_t MAX_CLIENTS = 16;
+    static constexpr size_t MAX_QUERY = 4096;
+
+    std::string path;
+    Handler handler;
+    std::string error;
+    int listenFd = -1;
+    int wakeFds[2] = {-1, -1}; // self-pipe, written by the destructor
+    std::thread worker;
+
+    void serve();
+};
@@ -0,0 +1,477 @@
+#include "Emulator.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include "LocalTime.h"
+
+namespace {
+
+const char checkpointMagic[8] = {'C', 'S', 'O', 'P', 'C', 'K', 'P', 'T'};
+const uint32_t checkpointVersion = 7;
+const uint32_t noProgram = UINT32_MAX;
+
+const char* stateName(Process::ProcessState state) {
+    switch (state) {
+        case Process::READY: return "READY";
+        case Process::RUNNING: return "RUNNING";
+        case Process::WAITING: return "WAITING";
+        case Process::FINISHED: return "FINISHED";
+    }
+    return "";
+}
+
+std::string formatTime(std::time_t time) {
+    if (time == -1) return "N/A";
+    std::tm local = toLocalTime(time);
+    char text[32];
+    std::strftime(text, sizeof(text), "%H:%M:%S %m/%d/%Y", &local);
+    return text;
+}
+
+} // namespace
+
+Emulator::Emulator(const Config& config) : config(config) {}
+
+const Config& Emulator::getConfig() const {
+    return config;
+}
+
+uint64_t Emulator::getSeed() const {
+    return seed;
+}
+
+void Emulator::setSeed(uint64_t newSeed) {
+    seed = newSeed;
+    generatorRng.reseed(seed, 1);
+    shellRng.reseed(seed, 2);
+}
+
+Scheduler& Emulator::startScheduler() {
+    if (!scheduler) {
+        scheduler = std::make_unique<Scheduler>(config.numCPU, config.schedulerAlgo, config.quantumCycles,
+                                                config.delayPerExec, config.maxOverallMem);
+        scheduler->setTracer(tracer);
+        setupSwapping();
+    }
+    return *scheduler;
+}
+
+Scheduler* Emulator::getScheduler() const {
+    return scheduler.get();
+}
+
+void Emulator::setTracer(Tracer* newTracer) {
+    tracer = newTracer;
+    if (scheduler) scheduler->setTracer(tracer);
+}
+
+void Emulator::setNumCores(int count) {
+    config.numCPU = count;
+    if (scheduler) scheduler->setNumCores(count);
+}
+
+// Swapping needs admission control; "backing-store none" turns it off
+void Emulator::setupSwapping() {
+    if (config.backingStore == "none" || !scheduler || !scheduler->getMemory()) return;
+    if (!scheduler->enableSwapping(config.backingStore, config.swapPrefetch)) {
+        std::cout << "Failed to open backing store " << config.backingStore << ", swapping is disabled.\n";
+    }
+}
+
+// Power of two between min-mem-per-proc and max-mem-per-proc
+int Emulator::randomMemorySize(Rng& rng) const {
+    size_t limit = static_cast<size_t>(std::max(config.maxMemPerProc, 0));
+    if (size_t usable = getUsableMemory()) limit = std::min(limit, usable);
+    int low = 0, high = 0;
+    while ((1 << low) < config.minMemPerProc) low++;
+    while ((size_t(2) << high) <= limit) high++;
+    if (high < low) return config.minMemPerProc;
+    return 1 << rng.between(low, high);
+}
+
+std::shared_ptr<Process> Emulator::createProcess(const std::string& name, std::shared_ptr<const Program> program, int memorySize,
+                                                 bool ownsProgram) {
+    auto proc = std::make_shared<Process>(++currentPID, name, 0);
+    proc->setProgram(std::move(program), ownsProgram);
+    proc->setMemorySize(memorySize);
+
+    processTable[name] = proc;
+    allProcesses.push_back(proc);
+    return proc;
+}
+
+std::shared_ptr<Process> Emulator::generateProcess(const std::string& name, bool fromShell, int memorySize) {
+    Rng& rng = fromShell ? shellRng : generatorRng;
+    int instructionCount = config.workload.instructionCount(rng, config.minInstructions, config.maxInstructions);
+    if (memorySize <= 0) memorySize = randomMemorySize(rng);
+    return createProcess(name, config.workload.generate(rng, instructionCount), memorySize, true);
+}
+
+std::string Emulator::nextProcessName() const {
+    return "p" + std::to_string(currentPID + 1);
+}
+
+bool Emulator::schedule(const std::shared_ptr<Process>& process) {
+    if (!scheduler) return false;
+    scheduler->addProcess(process);
+    return true;
+}
+
+std::shared_ptr<Process> Emulator::findProcess(const std::string& name) const {
+    auto it = processTable.find(name);
+    return it == processTable.end() ? nullptr : it->second;
+}
+
+const std::vector<std::shared_ptr<Process>>& Emulator::getProcesses() const {
+    return allProcesses;
+}
+
+int Emulator::getCurrentPID() const {
+    return currentPID;
+}
+
+size_t Emulator::getUsableMemory() const {
+    if (scheduler && scheduler->getMemory()) return scheduler->getMemory()->getTotalMemory();
+    return config.maxOverallMem > 0 ? MemoryManager::usableSize(config.maxOverallMem) : 0;
+}
+
+void Emulator::runTicks(uint64_t ticks) {
+    Scheduler& cpu = startScheduler();
+    uint64_t batchTicks = std::max<uint64_t>(1, static_cast<uint64_t>(config.batchProcessFreq) * 1000 / TICK_MILLISECONDS);
+    for (uint64_t i = 0; i < ticks; ++i) {
+        if (cpu.getTickCount() % batchTicks == 0) {
+            schedule(generateProcess(nextProcessName(), false));
+        }
+        cpu.tick();
+    }
+}
+
+Emulator::Snapshot::Row Emulator::rowOf(const Process& process) {
+    return Snapshot::Row{process.getName(), process.getPID(), process.getCoreID(), process.getState(),
+                         process.getCommandCounter(), process.getLinesOfCode(), process.isFinished(),
+                         process.isSwapped(), process.getFinishTime()};
+}
+
+const Emulator::Snapshot::Row* Emulator::Snapshot::find(const std::string& name) const {
+    for (const auto& row : processes) {
+        if (row.name == name) return &row;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<Emulator::Snapshot> Emulator::takeSnapshot(const std::vector<std::string>& logsOf) const {
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->takenAt = std::chrono::steady_clock::now();
+    snapshot->totalCores = config.numCPU;
+    snapshot->availableCores = scheduler ? scheduler->getAvailableCores() : config.numCPU;
+    snapshot->processes.reserve(processTable.size());
+    for (const auto& pair : processTable) {
+        snapshot->processes.push_back(rowOf(*pair.second));
+    }
+    for (const auto& name : logsOf) {
+        auto proc = findProcess(name);
+        snapshot->logs[name] = proc && !proc->isSwapped() ? proc->getOutput() : std::string();
+    }
+    snapshot->started = scheduler != nullptr;
+    if (scheduler) snapshot->vmstat = getVmstat();
+    return snapshot;
+}
+
+void Emulator::writeScreenList(std::ostream& out) const {
+    writeScreenList(out, *takeSnapshot({}));
+}
+
+void Emulator::writeScreenList(std::ostream& out, const Snapshot& snapshot) {
+    out << "=== CPU Utilization Summary ===\n";
+
+    out << "Total Cores: " << snapshot.totalCores << "\n";
+    out << "Used Cores: " << snapshot.totalCores - snapshot.availableCores << "\n";
+    out << "Available Cores: " << snapshot.availableCores << "\n\n";
+
+
+    out << "=== Currently RUNNING/READY/WAITING processes ===\n";
+    bool anyShown = false;
+    for (const auto& row : snapshot.processes) {
+        if (!row.finished) {
+            anyShown = true;
+            out << "  " << row.name
+                      << " (PID: " << row.pid
+                      << ", Core: " << row.core
+                      << ", State: " << stateName(row.state) << ", Progress: "
+                      << row.executed << "/" << row.total
+                      << ")\n";
+        }
+    }
+
+    if (!anyShown) {
+        out << "  No active processes.\n";
+    }
+
+    out << "\n=== Finished Processes ===\n";
+    bool anyFinished = false;
+    for (const auto& row : snapshot.processes) {
+        if (row.finished) {
+            anyFinished = true;
+            out << "  " << row.name
+                      << " (PID: " << row.pid
+                      << ", Core: " << row.core
+                      << ", Finished at: " << formatTime(row.finishTime)
+                      << ", Total Instructions: " << row.total
+                      << ")\n";
+        }
+    }
+    if (!anyFinished) {
+        out << "  No finished processes yet.\n";
+    }
+}
+
+void Emulator::writeProcessSmi(std::ostream& out, const Process& process) {
+    writeProcessSmi(out, rowOf(process), process.isSwapped() ? std::string() : process.getOutput());
+}
+
+void Emulator::writeProcessSmi(std::ostream& out, const Snapshot::Row& row, const std::string& log) {
+    out << "Name: " << row.name << "\n";
+    out << "PID: " << row.pid << "\n";
+    out << "Progress: " << row.executed << " / " << row.total << "\n";
+    out << "Core ID: " << row.core << "\n";
+    if (row.swapped) {
+        out << "Logs: (swapped out to the backing store)\n";
+    } else {
+        out << "Logs: " << log << "\n";
+    }
+    if (row.finished) {
+        out << "Finished at: " << formatTime(row.finishTime) << "\n";
+    }
+}
+
+Emulator::Vmstat Emulator::getVmstat() const {
+    Vmstat vmstat;
+    if (const MemoryManager* memory = scheduler->getMemory()) {
+        vmstat.hasMemory = true;
+        vmstat.totalMemory = memory->getTotalMemory();
+        vmstat.usedMemory = memory->getUsedMemory();
+        vmstat.allocatedBlocks = memory->getAllocatedBlocks();
+        vmstat.freeMemory = memory->getFreeMemory();
+        vmstat.largestFreeBlock = memory->getLargestFreeBlock();
+        vmstat.internalFragmentation = memory->getInternalFragmentation();
+        vmstat.externalFragmentation = memory->getExternalFragmentation();
+        vmstat.pendingProcesses = scheduler->getPendingCount();
+    }
+    if (const Swapper* swapper = scheduler->getSwapper()) {
+        vmstat.hasSwapper = true;
+        vmstat.swappedOut = swapper->getSwappedCount();
+        vmstat.swapOuts = swapper->getSwapOuts();
+        vmstat.bytesOut = swapper->getBytesOut();
+        vmstat.swapIns = swapper->getSwapIns();
+        vmstat.bytesIn = swapper->getBytesIn();
+        vmstat.prefetchHits = swapper->getPrefetchHits();
+        vmstat.backingStoreSize = swapper->getFileSize();
+    }
+    vmstat.metrics = scheduler->getMetrics();
+    return vmstat;
+}
+
+void Emulator::writeVmstat(std::ostream& out) const {
+    writeVmstat(out, getVmstat());
+}
+
+// Memory, backing store and scheduler metrics
+void Emulator::writeVmstat(std::ostream& out, const Vmstat& vmstat) {
+    if (vmstat.hasMemory) {
+        size_t freeMemory = vmstat.freeMemory;
+        size_t external = vmstat.externalFragmentation;
+        out << "=== Memory ===\n";
+        out << "Total memory: " << vmstat.totalMemory << " bytes\n";
+        out << "Used memory: " << vmstat.usedMemory << " bytes (" << vmstat.allocatedBlocks << " blocks)\n";
+        out << "Free memory: " << freeMemory << " bytes\n";
+        out << "Largest free block: " << vmstat.largestFreeBlock << " bytes\n";
+        out << "Internal fragmentation: " << vmstat.internalFragmentation << " bytes\n";
+        out << "External fragmentation: " << external << " bytes ("
+            << (freeMemory ? external * 100 / freeMemory : 0) << "% of free memory)\n";
+        out << "Processes waiting for memory: " << vmstat.pendingProcesses << "\n\n";
+    }
+
+    if (vmstat.hasSwapper) {
+        out << "=== Backing Store ===\n";
+        out << "Swapped-out processes: " << vmstat.swappedOut << "\n";
+        out << "Swap-outs: " << vmstat.swapOuts << " (" << vmstat.bytesOut << " bytes)\n";
+        out << "Swap-ins: " << vmstat.swapIns << " (" << vmstat.bytesIn << " bytes, "
+            << vmstat.prefetchHits << " prefetched)\n";
+        out << "Backing store size: " << vmstat.backingStoreSize << " bytes\n\n";
+    }
+
+    Scheduler::writeMetrics(out, vmstat.metrics);
+}
+
+// Layout (native byte order):
+//   magic, version, config, currentPID, seed and random streams,
+//   program images (deduplicated), processes (PID, name, program index, state),
+//   scheduler (cores, queues by PID, allocator, metrics) if one exists
+bool Emulator::save(BinaryWriter& out) const {
+    out.put(checkpointMagic);
+    out.put(checkpointVersion);
+
+    out.put(static_cast<int32_t>(config.numCPU));
+    out.putString(config.schedulerAlgo);
+    out.put(static_cast<int32_t>(config.quantumCycles));
+    out.put(static_cast<int32_t>(config.batchProcessFreq));
+    out.put(static_cast<int32_t>(config.minInstructions));
+    out.put(static_cast<int32_t>(config.maxInstructions));
+    out.put(static_cast<int32_t>(config.delayPerExec));
+    out.put(static_cast<int32_t>(config.maxOverallMem));
+    out.put(static_cast<int32_t>(config.minMemPerProc));
+    out.put(static_cast<int32_t>(config.maxMemPerProc));
+    out.put(static_cast<int32_t>(currentPID));
+    out.put(seed);
+    out.put(generatorRng);
+    out.put(shellRng);
+
+    // Swapped-out processes that owned their program carry it in their swap image
+    std::unordered_map<const Program*, uint32_t> programIndex{{nullptr, noProgram}};
+    std::vector<const Program*> programs;
+    for (const auto& proc : allProcesses) {
+        const Program* program = proc->getProgram().get();
+        if (programIndex.emplace(program, static_cast<uint32_t>(programs.size())).second) {
+            programs.push_back(program);
+        }
+    }
+    out.put(static_cast<uint32_t>(programs.size()));
+    for (const Program* program : programs) program->save(out);
+
+    Swapper* swapper = scheduler ? scheduler->getSwapper() : nullptr;
+    std::vector<char> image;
+    out.put(static_cast<uint32_t>(allProcesses.size()));
+    for (const auto& proc : allProcesses) {
+        out.put(static_cast<int32_t>(proc->getPID()));
+        out.putString(proc->getName());
+        out.put(programIndex[proc->getProgram().get()]);
+        proc->save(out);
+        if (proc->isSwapped()) {
+            if (!swapper || !swapper->readImage(proc->getPID(), image)) return false;
+            out.putArray(image);
+        }
+    }
+
+    out.put(static_cast<uint8_t>(scheduler != nullptr));
+    if (scheduler) scheduler->save(out);
+    return true;
+}
+
+std::unique_ptr<Emulator> Emulator::load(BinaryReader& in, const Config& base, std::string& error) {
+    char magic[8] = {};
+    uint32_t version = 0;
+    in.get(magic);
+    in.get(version);
+    if (!in.ok() || std::memcmp(magic, checkpointMagic, sizeof(magic)) != 0) {
+        error = "not a checkpoint file";
+        return nullptr;
+    }
+    if (version != checkpointVersion) {
+        error = "unsupported checkpoint version " + std::to_string(version);
+        return nullptr;
+    }
+
+    int32_t cpus = 0, quantum = 0, batchFreq = 0, minIns = 0, maxIns = 0, delay = 0, pid = 0;
+    int32_t overallMem = 0, minMem = 0, maxMem = 0;
+    uint64_t seed = 0;
+    Rng generatorRng, shellRng;
+    std::string algorithm;
+    in.get(cpus);
+    in.getString(algorithm);
+    in.get(quantum);
+    in.get(batchFreq);
+    in.get(minIns);
+    in.get(maxIns);
+    in.get(delay);
+    in.get(overallMem);
+    in.get(minMem);
+    in.get(maxMem);
+    in.get(pid);
+    in.get(seed);
+    in.get(generatorRng);
+    in.get(shellRng);
+
+    uint32_t programCount = 0;
+    std::vector<std::shared_ptr<const Program>> programs;
+    if (in.get(programCount)) {
+        programs.reserve(std::min<size_t>(programCount, in.remaining()));
+        for (uint32_t i = 0; i < programCount && in.ok(); ++i) {
+            auto program = Program::load(in);
+            if (!program) break;
+            programs.push_back(std::move(program));
+        }
+    }
+
+    uint32_t processCount = 0;
+    std::vector<std::shared_ptr<Process>> restored;
+    std::unordered_map<int, std::shared_ptr<Process>> byPID;
+    if (programs.size() == programCount && in.get(processCount)) {
+        restored.reserve(std::min<size_t>(processCount, in.remaining()));
+        byPID.reserve(restored.capacity());
+        for (uint32_t i = 0; i < processCount; ++i) {
+            int32_t procPID = 0;
+            uint32_t programIndex = 0;
+            std::string name;
+            in.get(procPID);
+            in.getString(name);
+            in.get(programIndex);
+            if (!in.ok() || (programIndex >= programs.size() && programIndex != noProgram)) break;
+
+            auto proc = std::make_shared<Process>(procPID, name, 0);
+            if (programIndex != noProgram) proc->setProgram(programs[programIndex]);
+            if (!proc->load(in)) break;
+            if (proc->isSwapped()) {
+                // Restored processes start resident, without memory
+                std::vector<char> image;
+                in.getArray(image);
+                BinaryReader imageReader(image.data(), image.size());
+                if (!in.ok() || !proc->swapIn(imageReader)) break;
+            } else if (programIndex == noProgram) {
+                break;
+            }
+            byPID[procPID] = proc;
+            restored.push_back(std::move(proc));
+        }
+    }
+
+    Config config = base;
+    config.numCPU = cpus;
+    config.schedulerAlgo = algorithm;
+    config.quantumCycles = quantum;
+    config.batchProcessFreq = batchFreq;
+    config.minInstructions = minIns;
+    config.maxInstructions = maxIns;
+    config.delayPerExec = delay;
+    config.maxOverallMem = overallMem;
+    config.minMemPerProc = minMem;
+    config.maxMemPerProc = maxMem;
+
+    std::unique_ptr<Scheduler> restoredScheduler;
+    uint8_t hasScheduler = 0;
+    bool ok = restored.size() == processCount && in.get(hasScheduler);
+    if (ok && hasScheduler) {
+        restoredScheduler = std::make_unique<Scheduler>(cpus, algorithm, quantum, delay, overallMem);
+        ok = restoredScheduler->load(in, [&byPID](int id) {
+            auto it = byPID.find(id);
+            return it == byPID.end() ? nullptr : it->second;
+        });
+    }
+    if (!ok || !in.atEnd() || cpus <= 0) {
+        error = "corrupt checkpoint";
+        return nullptr;
+    }
+
+    auto emulator = std::make_unique<Emulator>(config);
+    emulator->currentPID = pid;
+    // Carry on the streams where they stopped, not from the seed
+    emulator->seed = seed;
+    emulator->generatorRng = generatorRng;
+    emulator->shellRng = shellRng;
+    emulator->allProcesses = std::move(restored);
+    emulator->processTable.reserve(emulator->allProcesses.size());
+    for (const auto& proc : emulator->allProcesses) {
+        emulator->processTable[proc->getName()] = proc;
+    }
+    emulator->scheduler = std::move(restoredScheduler);
+    return emulator;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BinaryIO.h"
+#include "Config.h"
+#include "Process.h"
+#include "Rng.h"
+#include "Scheduler.h"
+#include "Tracer.h"
+
+// One simulated machine: its configuration, processes, scheduler and
+// random streams. It takes no locks; the console drives one instance from
+// its tick and generator threads under its state lock, and sweep runs many
+// instances side by side with runTicks(). Its only thread is the swap
+// prefetch worker, started when swapping is on and swap-prefetch > 0.
+class Emulator {
+public:
+    static constexpr int TICK_MILLISECONDS = 100; // one CPU cycle in real time
+
+    explicit Emulator(const Config& config);
+
+    const Config& getConfig() const;
+    uint64_t getSeed() const;
+    // The generator and the shell draw from separate streams, so a fixed
+    // seed reproduces the generated processes however commands interleave
+    void setSeed(uint64_t seed);
+
+    // Creates the scheduler if there is none yet (a stopped or restored one is kept)
+    Scheduler& startScheduler();
+    Scheduler* getScheduler() const; // nullptr until started
+    void setTracer(Tracer* tracer);  // handed to the scheduler, not owned
+    void setNumCores(int count);
+
+    // ownsProgram: see Process::setProgram()
+    std::shared_ptr<Process> createProcess(const std::string& name, std::shared_ptr<const Program> program, int memorySize,
+                                           bool ownsProgram = false);
+    // Dummy process shaped by the workload; fromShell picks the shell's stream
+    std::shared_ptr<Process> generateProcess(const std::string& name, bool fromShell, int memorySize = 0);
+    std::string nextProcessName() const; // p<next PID>
+    bool schedule(const std::shared_ptr<Process>& process); // false until the scheduler is started
+
+    std::shared_ptr<Process> findProcess(const std::string& name) const;
+    const std::vector<std::shared_ptr<Process>>& getProcesses() const;
+    int getCurrentPID() const;
+    // max-overall-mem as the allocator rounds it; 0 without admission control
+    size_t getUsableMemory() const;
+
+    // Headless run: ticks, generating a process every batch-process-freq
+    // seconds of simulated time, as the console's generator thread would
+    void runTicks(uint64_t ticks);
+
+    // The numbers behind vmstat
+    struct Vmstat {
+        bool hasMemory = false;
+        size_t totalMemory = 0;
+        size_t usedMemory = 0;
+        size_t allocatedBlocks = 0;
+        size_t freeMemory = 0;
+        size_t largestFreeBlock = 0;
+        size_t internalFragmentation = 0;
+        size_t externalFragmentation = 0;
+        size_t pendingProcesses = 0;
+        bool hasSwapper = false;
+        size_t swappedOut = 0;
+        uint64_t swapOuts = 0;
+        uint64_t bytesOut = 0;
+        uint64_t swapIns = 0;
+        uint64_t bytesIn = 0;
+        uint64_t prefetchHits = 0;
+        uint64_t backingStoreSize = 0;
+        Scheduler::Metrics metrics;
+    };
+
+    // Everything screen -ls, process-smi and vmstat show, copied so another
+    // thread can format it without the state lock. Logs can be large, so
+    // only those of the processes asked for are copied.
+    struct Snapshot {
+        struct Row {
+            std::string name;
+            int pid;
+            int core;
+            Process::ProcessState state;
+            uint64_t executed;
+            uint64_t total;
+            bool finished;
+            bool swapped;
+            std::time_t finishTime; // -1 until finished
+        };
+        std::chrono::steady_clock::time_point takenAt;
+        int totalCores = 0;
+        int availableCores = 0;
+        std::vector<Row> processes; // in screen -ls order
+        std::unordered_map<std::string, std::string> logs; // one entry per name asked for
+        bool started = false;
+        Vmstat vmstat; // only if started
+
+        const Row* find(const std::string& name) const;
+    };
+    std::shared_ptr<Snapshot> takeSnapshot(const std::vector<std::string>& logsOf) const;
+
+    void writeScreenList(std::ostream& out) const; // screen -ls
+    void writeVmstat(std::ostream& out) const;     // needs a started scheduler
+    static void writeProcessSmi(std::ostream& out, const Process& process);
+    static void writeScreenList(std::ostream& out, const Snapshot& snapshot);
+    static void writeVmstat(std::ostream& out, const Vmstat& vmstat);
+    static void writeProcessSmi(std::ostream& out, const Snapshot::Row& row, const std::string& log);
+
+    // Checkpoint format: config, processes and scheduler. Settings that
+    // are not saved (backing store, workload, ...) come from base on load.
+    bool save(BinaryWriter& out) const; // false if a swap image cannot be read
+    // Swapping stays off on a loaded engine until setupSwapping(): the
+    // backing store is truncated on open and removed by its old owner.
+    static std::unique_ptr<Emulator> load(BinaryReader& in, const Config& base, std::string& error);
+    void setupSwapping(); // no-op without a started scheduler
+
+private:
+    Config config;
+    uint64_t seed = 0;
+    Rng generatorRng;
+    Rng shellRng;
+    int currentPID = 0;
+    std::unique_ptr<Scheduler> scheduler;
+    Tracer* tracer = nullptr;
+
+    std::unordered_map<std::string, std::shared_ptr<Process>> processTable;
+    std::vector<std::shared_ptr<Process>> allProcesses;
+
+    int randomMemorySize(Rng& rng) const;
+    Vmstat getVmstat() const;
+    static Snapshot::Row rowOf(const Process& process);
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Log2-bucketed histogram of tick counts. Bucket 0 holds zeros and bucket
+// i holds values in [2^(i-1), 2^i), so recording is a few instructions and
+// percentiles are accurate to within a factor of two. Trivially copyable,
+// so checkpoints store it as it is.
+class Histogram {
+public:
+    void record(uint64_t value) {
+        buckets[bucketFor(value)]++;
+        count++;
+        sum += value;
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+
+    uint64_t getCount() const { return count; }
+    uint64_t getMin() const { return count ? min : 0; }
+    uint64_t getMax() const { return max; }
+    double getMean() const { return count ? static_cast<double>(sum) / count : 0.0; }
+
+    // Upper bound of the bucket holding the p-th percentile (0 < p <= 100)
+    uint64_t percentile(double p) const {
+        if (count == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * count + 0.5);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                uint64_t upper = (i == 0) ? 0 : (i >= 64 ? UINT64_MAX : (uint64_t(1) << i) - 1);
+                return upper < max ? upper : max;
+            }
+        }
+        return max;
+    }
+
+private:
+    std::array<uint64_t, 65> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+
+    static size_t bucketFor(uint64_t value) {
+        size_t bucket = 0;
+        while (value) {
+            bucket++;
+            value >>= 1;
+        }
+        return bucket;
+    }
+};
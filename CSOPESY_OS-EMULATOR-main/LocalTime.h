@@ -0,0 +1,16 @@
+#pragma once
+#include <ctime>
+
+// std::localtime returns a shared static tm, which races when the tick
+// thread, the report-util thread or parallel sweep instances format times
+// at the same moment.
+// This fills a caller-owned tm instead.
+inline std::tm toLocalTime(std::time_t time) {
+    std::tm local{};
+#ifdef _WIN32
+    localtime_s(&local, &time);
+#else
+    localtime_r(&time, &local);
+#endif
+    return local;
+}
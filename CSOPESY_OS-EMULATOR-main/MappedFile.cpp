@@ -0,0 +1,75 @@
+#include "MappedFile.h"
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length == 0) {
+        ::close(fd);
+        ptr = contents.data();
+        return true;
+    }
+
+    void* addr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (addr == MAP_FAILED) {
+        length = 0;
+        return false;
+    }
+    madvise(addr, length, MADV_SEQUENTIAL);
+    ptr = static_cast<const char*>(addr);
+    mapped = true;
+    return true;
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+    length = static_cast<size_t>(file.tellg());
+    contents.resize(length);
+    file.seekg(0);
+    if (!file.read(contents.data(), length)) {
+        close();
+        return false;
+    }
+    ptr = contents.data();
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifndef _WIN32
+    if (mapped) munmap(const_cast<char*>(ptr), length);
+#endif
+    mapped = false;
+    ptr = nullptr;
+    length = 0;
+    contents.clear();
+}
+
+const char* MappedFile::data() const {
+    return ptr;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
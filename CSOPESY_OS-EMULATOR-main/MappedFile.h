@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Read-only view of a whole file. Uses mmap so large checkpoints are paged
+// in on demand; on Windows the file is read into memory instead.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const;
+    size_t size() const;
+
+private:
+    const char* ptr = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::vector<char> contents; // fallback when the file is not mapped
+};
@@ -0,0 +1,173 @@
+#include "MemoryManager.h"
+#include <algorithm>
+
+MemoryManager::MemoryManager(size_t size) : totalSize(usableSize(size)), maxOrder(0) {
+    while (blockSize(maxOrder) < totalSize) maxOrder++;
+    freeLists.resize(maxOrder + 1);
+    freeLists[maxOrder].insert(0);
+}
+
+size_t MemoryManager::usableSize(size_t size) {
+    size_t total = MIN_BLOCK;
+    while (total * 2 <= size) total *= 2;
+    return total;
+}
+
+size_t MemoryManager::blockSize(uint8_t order) const {
+    return MIN_BLOCK << order;
+}
+
+uint8_t MemoryManager::orderFor(size_t size) const {
+    uint8_t order = 0;
+    while (blockSize(order) < size) order++;
+    return order;
+}
+
+size_t MemoryManager::allocate(size_t size) {
+    if (size == 0 || size > totalSize) return NO_BLOCK;
+
+    uint8_t want = orderFor(size);
+    uint8_t order = want;
+    while (order <= maxOrder && freeLists[order].empty()) order++;
+    if (order > maxOrder) return NO_BLOCK;
+
+    // Take the lowest free block and split it, keeping the upper halves free
+    size_t offset = *freeLists[order].begin();
+    freeLists[order].erase(freeLists[order].begin());
+    while (order > want) {
+        order--;
+        freeLists[order].insert(offset + blockSize(order));
+    }
+
+    allocated[offset] = Block{want, size};
+    usedMemory += blockSize(want);
+    requestedMemory += size;
+    return offset;
+}
+
+void MemoryManager::free(size_t offset) {
+    auto it = allocated.find(offset);
+    if (it == allocated.end()) return;
+
+    uint8_t order = it->second.order;
+    usedMemory -= blockSize(order);
+    requestedMemory -= it->second.requested;
+    allocated.erase(it);
+
+    // Merge with the buddy for as long as it is free too
+    while (order < maxOrder) {
+        size_t buddy = offset ^ blockSize(order);
+        auto match = freeLists[order].find(buddy);
+        if (match == freeLists[order].end()) break;
+        freeLists[order].erase(match);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+    freeLists[order].insert(offset);
+}
+
+bool MemoryManager::canAllocate(size_t size) const {
+    if (size == 0 || size > totalSize) return false;
+    for (uint8_t order = orderFor(size); order <= maxOrder; ++order) {
+        if (!freeLists[order].empty()) return true;
+    }
+    return false;
+}
+
+size_t MemoryManager::getTotalMemory() const {
+    return totalSize;
+}
+
+size_t MemoryManager::getUsedMemory() const {
+    return usedMemory;
+}
+
+size_t MemoryManager::getFreeMemory() const {
+    return totalSize - usedMemory;
+}
+
+size_t MemoryManager::getRequestedMemory() const {
+    return requestedMemory;
+}
+
+size_t MemoryManager::getLargestFreeBlock() const {
+    for (int order = maxOrder; order >= 0; --order) {
+        if (!freeLists[order].empty()) return blockSize(static_cast<uint8_t>(order));
+    }
+    return 0;
+}
+
+size_t MemoryManager::getInternalFragmentation() const {
+    return usedMemory - requestedMemory;
+}
+
+size_t MemoryManager::getExternalFragmentation() const {
+    return getFreeMemory() - getLargestFreeBlock();
+}
+
+size_t MemoryManager::getAllocatedBlocks() const {
+    return allocated.size();
+}
+
+void MemoryManager::save(BinaryWriter& out) const {
+    out.put(static_cast<uint64_t>(totalSize));
+    out.put(static_cast<uint32_t>(allocated.size()));
+    for (const auto& entry : allocated) {
+        out.put(static_cast<uint64_t>(entry.first));
+        out.put(entry.second.order);
+        out.put(static_cast<uint64_t>(entry.second.requested));
+    }
+}
+
+bool MemoryManager::load(BinaryReader& in) {
+    uint64_t size = 0;
+    uint32_t count = 0;
+    if (!in.get(size) || size != totalSize || !in.get(count)) return false;
+
+    for (auto& list : freeLists) list.clear();
+    freeLists[maxOrder].insert(0);
+    allocated.clear();
+    usedMemory = 0;
+    requestedMemory = 0;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t offset = 0, requested = 0;
+        uint8_t order = 0;
+        in.get(offset);
+        in.get(order);
+        in.get(requested);
+        if (!in.ok() || !claim(offset, order)) return false;
+
+        allocated[offset] = Block{order, static_cast<size_t>(requested)};
+        usedMemory += blockSize(order);
+        requestedMemory += requested;
+    }
+    return true;
+}
+
+// Carves the block (offset, order) out of whichever free block contains it
+bool MemoryManager::claim(size_t offset, uint8_t order) {
+    if (order > maxOrder || offset % blockSize(order) != 0 || offset + blockSize(order) > totalSize) {
+        return false;
+    }
+
+    for (uint8_t k = order; k <= maxOrder; ++k) {
+        size_t start = offset & ~(blockSize(k) - 1);
+        auto it = freeLists[k].find(start);
+        if (it == freeLists[k].end()) continue;
+
+        freeLists[k].erase(it);
+        while (k > order) {
+            k--;
+            size_t half = blockSize(k);
+            if (offset & half) {
+                freeLists[k].insert(start);
+                start += half;
+            } else {
+                freeLists[k].insert(start + half);
+            }
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "BinaryIO.h"
+
+// Buddy allocator over a fixed-size simulated memory. Blocks are powers of
+// two from MIN_BLOCK up to the whole memory; each order keeps an ordered
+// free list, so allocate and free are O(log n) and freed blocks coalesce
+// with their buddy.
+class MemoryManager {
+public:
+    static constexpr size_t MIN_BLOCK = 64;
+    static constexpr size_t NO_BLOCK = SIZE_MAX;
+
+    // totalSize is rounded down to a power of two, and must be at least
+    // MIN_BLOCK (Config::check rejects smaller memories)
+    explicit MemoryManager(size_t totalSize);
+    static size_t usableSize(size_t totalSize); // the size after rounding
+
+    size_t allocate(size_t size); // offset of the block, or NO_BLOCK
+    void free(size_t offset);
+    bool canAllocate(size_t size) const;
+
+    size_t getTotalMemory() const;
+    size_t getUsedMemory() const;      // bytes in allocated blocks
+    size_t getFreeMemory() const;
+    size_t getRequestedMemory() const; // bytes actually asked for
+    size_t getLargestFreeBlock() const;
+    size_t getInternalFragmentation() const; // used - requested
+    size_t getExternalFragmentation() const; // free bytes outside the largest free block
+    size_t getAllocatedBlocks() const;
+
+    // Checkpoint support: the allocated blocks, free lists are rebuilt on load
+    void save(BinaryWriter& out) const;
+    bool load(BinaryReader& in);
+
+private:
+    struct Block {
+        uint8_t order;
+        size_t requested;
+    };
+
+    size_t totalSize;
+    uint8_t maxOrder; // the whole memory is one block of this order
+    std::vector<std::set<size_t>> freeLists; // per order, block offsets
+    std::unordered_map<size_t, Block> allocated;
+    size_t usedMemory = 0;
+    size_t requestedMemory = 0;
+
+    size_t blockSize(uint8_t order) const;
+    uint8_t orderFor(size_t size) const;
+    bool claim(size_t offset, uint8_t order);
+};
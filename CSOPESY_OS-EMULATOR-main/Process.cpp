@@ -2,6 +2,9 @@
 #include <iostream>
 #include <iomanip>
 #include <sstream> 
+#include <chrono>
+#include <ctime>
+#include "LocalTime.h"
 
 Process::Process(int pid, const std::string& name, int lines)
     : pid(pid), name(name), commandCounter(0), linesOfCode(lines),
@@ -17,9 +20,23 @@ void Process::executeNextInstruction(int coreID) {
         return;
     }
 
-    if (commandCounter < linesOfCode && commandCounter < instructions.size()) {
-        instructions[commandCounter]->execute(name, coreID, variables, outputLog, sleeping, sleepTicks);
-        commandCounter++;
+    if (program && commandCounter < linesOfCode) {
+        const auto& code = program->code;
+        // Loop control is free, run it until the next real instruction
+        while (pc < code.size()) {
+            const Op& op = code[pc];
+            if (op.code == OpCode::FOR_BEGIN) {
+                registers[op.dst] = op.a;
+                pc = (op.a > 0) ? pc + 1 : op.b;
+            } else if (op.code == OpCode::LOOP_END) {
+                pc = (--registers[op.dst] > 0) ? op.a : pc + 1;
+            } else {
+                execute(op, coreID);
+                pc++;
+                commandCounter++;
+                break;
+            }
+        }
     }
 
     if (commandCounter >= linesOfCode) {
@@ -28,6 +45,43 @@ void Process::executeNextInstruction(int coreID) {
     }
 }
 
+uint16_t Process::operand(const Op& op, uint8_t literalFlag, uint16_t field) const {
+    return (op.flags & literalFlag) ? field : registers[field];
+}
+
+void Process::execute(const Op& op, int coreID) {
+    switch (op.code) {
+        case OpCode::PRINT: {
+            auto now = std::chrono::system_clock::now();
+            std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+            std::tm local_tm = toLocalTime(now_time);
+
+            std::ostringstream oss;
+            oss << "Core " << coreID << " | " << name << ": " << program->strings[op.a];
+            if (op.flags & Program::PRINT_VAR) oss << registers[op.b];
+            oss << " [" << std::put_time(&local_tm, "%H:%M:%S %m/%d/%Y") << "]\n";
+            outputLog += oss.str();
+            break;
+        }
+        case OpCode::DECLARE:
+            registers[op.dst] = operand(op, Program::A_LITERAL, op.a);
+            break;
+        case OpCode::ADD:
+            registers[op.dst] = operand(op, Program::A_LITERAL, op.a) + operand(op, Program::B_LITERAL, op.b);
+            break;
+        case OpCode::SUBTRACT:
+            registers[op.dst] = operand(op, Program::A_LITERAL, op.a) - operand(op, Program::B_LITERAL, op.b);
+            break;
+        case OpCode::SLEEP:
+            sleeping = true;
+            sleepTicks = operand(op, Program::A_LITERAL, op.a);
+            break;
+        case OpCode::FOR_BEGIN:
+        case OpCode::LOOP_END:
+            break; // handled by executeNextInstruction
+    }
+}
+
 bool Process::isFinished() const {
     return currentState == FINISHED;
 }
@@ -40,11 +94,11 @@ int Process::getPID() const {
     return pid;
 }
 
-int Process::getCommandCounter() const {
+uint64_t Process::getCommandCounter() const {
     return commandCounter;
 }
 
-int Process::getLinesOfCode() const {
+uint64_t Process::getLinesOfCode() const {
     return linesOfCode;
 }
 
@@ -60,6 +114,10 @@ std::string Process::getOutput() const {
     return outputLog;
 }
 
+std::shared_ptr<const Program> Process::getProgram() const {
+    return program;
+}
+
 void Process::setCoreID(int coreID) {
     this->coreID = coreID;
 }
@@ -68,8 +126,29 @@ void Process::setState(ProcessState newState) {
     currentState = newState;
 }
 
-void Process::setInstructions(const std::vector<std::shared_ptr<Instruction>>& insts) {
-    instructions = insts;
+void Process::setProgram(std::shared_ptr<const Program> program, bool owned) {
+    this->program = std::move(program);
+    programOwned = owned;
+    registers.assign(this->program->registerCount(), 0);
+    linesOfCode = this->program->instructionCount;
+    commandCounter = 0;
+    pc = 0;
+}
+
+int Process::getMemorySize() const {
+    return memorySize;
+}
+
+void Process::setMemorySize(int size) {
+    memorySize = size;
+}
+
+size_t Process::getMemoryAddress() const {
+    return memoryAddress;
+}
+
+void Process::setMemoryAddress(size_t address) {
+    memoryAddress = address;
 }
 
 void Process::markFinished() {
@@ -82,8 +161,147 @@ void Process::markFinished() {
 std::string Process::getFinishTimeString() const {
     if (!hasFinishTime) return "N/A";
     std::time_t finish_time = std::chrono::system_clock::to_time_t(finishTime);
-    std::tm local_tm = *std::localtime(&finish_time);
+    std::tm local_tm = toLocalTime(finish_time);
     std::ostringstream oss;
     oss << std::put_time(&local_tm, "%H:%M:%S %m/%d/%Y");
     return oss.str();
 }
+
+std::time_t Process::getFinishTime() const {
+    if (!hasFinishTime) return -1;
+    return std::chrono::system_clock::to_time_t(finishTime);
+}
+
+void Process::save(BinaryWriter& out) const {
+    out.put(commandCounter);
+    out.put(linesOfCode);
+    out.put(pc);
+    out.put(static_cast<int32_t>(coreID));
+    out.put(static_cast<uint8_t>(currentState));
+    out.put(static_cast<uint8_t>(sleeping));
+    out.put(static_cast<int32_t>(sleepTicks));
+    out.put(static_cast<int32_t>(memorySize));
+    out.put(static_cast<uint64_t>(memoryAddress));
+    out.put(static_cast<uint8_t>(hasFinishTime));
+    out.put(static_cast<int64_t>(finishTime.time_since_epoch().count()));
+    out.put(timing);
+    out.put(static_cast<uint8_t>(programOwned));
+    out.put(static_cast<uint8_t>(swapped));
+    if (!swapped) saveResident(out);
+}
+
+bool Process::load(BinaryReader& in) {
+    int32_t core = 0, ticks = 0, memory = 0;
+    uint8_t state = 0, isSleeping = 0, finished = 0, owned = 0, isSwapped = 0;
+    int64_t finishCount = 0;
+    uint64_t address = 0;
+
+    in.get(commandCounter);
+    in.get(linesOfCode);
+    in.get(pc);
+    in.get(core);
+    in.get(state);
+    in.get(isSleeping);
+    in.get(ticks);
+    in.get(memory);
+    in.get(address);
+    in.get(finished);
+    in.get(finishCount);
+    in.get(timing);
+    in.get(owned);
+    in.get(isSwapped);
+    if (!in.ok() || state > FINISHED) return false;
+
+    coreID = core;
+    currentState = static_cast<ProcessState>(state);
+    sleeping = isSleeping != 0;
+    sleepTicks = ticks;
+    memorySize = memory;
+    memoryAddress = static_cast<size_t>(address);
+    hasFinishTime = finished != 0;
+    programOwned = owned != 0;
+    finishTime = std::chrono::system_clock::time_point(std::chrono::system_clock::duration(finishCount));
+
+    if (isSwapped) {
+        swapOut(); // the caller follows up with swapIn() and the swap image
+        return true;
+    }
+    return program && loadResident(in);
+}
+
+void Process::saveResident(BinaryWriter& out) const {
+    out.putArray(registers);
+    out.putString(outputLog);
+}
+
+bool Process::loadResident(BinaryReader& in) {
+    std::vector<uint16_t> savedRegisters;
+    std::string savedLog;
+    in.getArray(savedRegisters);
+    in.getString(savedLog);
+    if (!in.ok() || savedRegisters.size() != program->registerCount() || pc > program->code.size()) {
+        return false;
+    }
+
+    registers = std::move(savedRegisters);
+    outputLog = std::move(savedLog);
+    swapped = false;
+    return true;
+}
+
+bool Process::isSleeping() const {
+    return sleeping;
+}
+
+int Process::getSleepTicks() const {
+    return sleepTicks;
+}
+
+bool Process::isSwapped() const {
+    return swapped;
+}
+
+bool Process::ownsProgram() const {
+    return program && programOwned;
+}
+
+void Process::writeSwapImage(BinaryWriter& out) const {
+    out.put(static_cast<uint8_t>(ownsProgram()));
+    if (ownsProgram()) program->save(out);
+    saveResident(out);
+}
+
+void Process::swapOut() {
+    if (ownsProgram()) program.reset();
+    std::vector<uint16_t>().swap(registers);
+    std::string().swap(outputLog);
+    swapped = true;
+}
+
+bool Process::swapIn(BinaryReader& in) {
+    uint8_t hasProgram = 0;
+    if (!in.get(hasProgram)) return false;
+    if (hasProgram) {
+        auto image = Program::load(in);
+        if (!image) return false;
+        program = std::move(image);
+        programOwned = true;
+    }
+    return program && loadResident(in);
+}
+
+uint64_t Process::getLastScheduledTick() const {
+    return lastScheduledTick;
+}
+
+void Process::setLastScheduledTick(uint64_t tick) {
+    lastScheduledTick = tick;
+}
+
+Process::Timing& Process::getTiming() {
+    return timing;
+}
+
+const Process::Timing& Process::getTiming() const {
+    return timing;
+}
@@ -5,7 +5,9 @@
 #include <memory>
 #include <cstdint>
 #include <chrono>
-#include "Instruction.h"
+#include <ctime>
+#include "Program.h"
+#include "BinaryIO.h"
 
 class Process {
 public:
@@ -16,34 +18,89 @@ public:
     Process(int pid, const std::string& name, int lines);
     void executeNextInstruction(int coreID);
     bool isFinished() const;
+    bool isSleeping() const;
+    int getSleepTicks() const; // ticks left to sleep
 
     std::string getName() const;
     int getPID() const;
-    int getCommandCounter() const;
-    int getLinesOfCode() const;
+    uint64_t getCommandCounter() const; // instructions executed so far
+    uint64_t getLinesOfCode() const;    // instructions executed by a full run, loops included
     int getCoreID() const;
     ProcessState getState() const;
     std::string getOutput() const;
+    std::shared_ptr<const Program> getProgram() const;
 
     void setCoreID(int coreID);
     void setState(ProcessState newState);
-    void setInstructions(const std::vector<std::shared_ptr<Instruction>>& insts);
+    // owned: generated for this process alone, so swapping out drops it and
+    // the swap image carries it; shared programs (the script cache) stay put
+    void setProgram(std::shared_ptr<const Program> program, bool owned = false);
+
+    static constexpr size_t NO_MEMORY = SIZE_MAX;
+
+    int getMemorySize() const;
+    void setMemorySize(int size);
+    size_t getMemoryAddress() const; // NO_MEMORY until admitted
+    void setMemoryAddress(size_t address);
+
+    // Checkpoint support. The program image is saved separately (it is
+    // shared); load() expects setProgram() to have been called first unless
+    // the process was saved swapped out, in which case swapIn() follows.
+    void save(BinaryWriter& out) const;
+    bool load(BinaryReader& in);
+
+    // Swapping. The image holds the registers, the output log and the
+    // program when no other process shares it; swapOut() then drops them.
+    bool isSwapped() const;
+    void writeSwapImage(BinaryWriter& out) const;
+    void swapOut();
+    bool swapIn(BinaryReader& in);
+
+    uint64_t getLastScheduledTick() const;
+    void setLastScheduledTick(uint64_t tick);
+
+    // Kept by the scheduler, in scheduler ticks
+    struct Timing {
+        static constexpr uint64_t NOT_YET = UINT64_MAX;
+        uint64_t arrival = 0;
+        uint64_t firstRun = NOT_YET;
+        uint64_t finish = NOT_YET;
+        uint64_t waited = 0;     // ticks spent in the ready queue
+        uint64_t readySince = 0; // when it last entered the ready queue
+    };
+    Timing& getTiming();
+    const Timing& getTiming() const;
 
     //for the finished time sa process
     std::string getFinishTimeString() const;
+    std::time_t getFinishTime() const; // -1 until finished
     void markFinished();
 
 private:
     int pid;
     std::string name;
-    int commandCounter;
-    int linesOfCode;
+    uint64_t commandCounter;
+    uint64_t linesOfCode;
     int coreID;
     ProcessState currentState;
 
-    std::vector<std::shared_ptr<Instruction>> instructions;
-    std::unordered_map<std::string, uint16_t> variables;
+    bool swapped = false;
+    uint64_t lastScheduledTick = 0; // scheduler tick of the last dispatch, or arrival
+    Timing timing;
+
+    void execute(const Op& op, int coreID);
+    void saveResident(BinaryWriter& out) const;
+    bool loadResident(BinaryReader& in);
+    bool ownsProgram() const;
+    uint16_t operand(const Op& op, uint8_t literalFlag, uint16_t field) const;
+
+    std::shared_ptr<const Program> program;
+    bool programOwned = false;
+    std::vector<uint16_t> registers; // program variables, then loop counters
+    uint32_t pc = 0;                 // index of the next op in program->code
     std::string outputLog;
+    int memorySize = 0;
+    size_t memoryAddress = NO_MEMORY;
 
     bool sleeping = false;
     int sleepTicks = 0;
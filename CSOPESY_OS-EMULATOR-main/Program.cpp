@@ -0,0 +1,115 @@
+#include "Program.h"
+#include "BinaryIO.h"
+#include <algorithm>
+
+uint16_t Program::symbol(std::string_view name) {
+    // Symbol tables are capped at MAX_VARIABLES, a linear scan beats hashing
+    for (size_t i = 0; i < symbols.size(); ++i) {
+        if (symbols[i] == name) return static_cast<uint16_t>(i);
+    }
+    if (symbols.size() >= MAX_VARIABLES) return NO_SLOT;
+    symbols.emplace_back(name);
+    return static_cast<uint16_t>(symbols.size() - 1);
+}
+
+uint16_t Program::addString(std::string_view text) {
+    for (size_t i = 0; i < strings.size(); ++i) {
+        if (strings[i] == text) return static_cast<uint16_t>(i);
+    }
+    strings.emplace_back(text);
+    return static_cast<uint16_t>(strings.size() - 1);
+}
+
+void Program::finalize() {
+    uint16_t counterBase = static_cast<uint16_t>(symbols.size());
+    std::vector<uint64_t> repeats{1};
+    instructionCount = 0;
+    loopDepth = 0;
+
+    for (auto& op : code) {
+        switch (op.code) {
+            case OpCode::FOR_BEGIN:
+                loopDepth = std::max<uint16_t>(loopDepth, op.dst + 1);
+                op.dst += counterBase;
+                repeats.push_back(repeats.back() * op.a);
+                break;
+            case OpCode::LOOP_END:
+                op.dst += counterBase;
+                repeats.pop_back();
+                break;
+            default:
+                instructionCount += repeats.back();
+                break;
+        }
+    }
+}
+
+uint16_t Program::registerCount() const {
+    return static_cast<uint16_t>(symbols.size() + loopDepth);
+}
+
+void Program::save(BinaryWriter& out) const {
+    out.putArray(code);
+    out.put(static_cast<uint32_t>(symbols.size()));
+    for (const auto& symbol : symbols) out.putString(symbol);
+    out.put(static_cast<uint32_t>(strings.size()));
+    for (const auto& text : strings) out.putString(text);
+    out.put(loopDepth);
+    out.put(instructionCount);
+}
+
+std::shared_ptr<Program> Program::load(BinaryReader& in) {
+    auto program = std::make_shared<Program>();
+    uint32_t count = 0;
+
+    in.getArray(program->code);
+    if (in.get(count) && count <= MAX_VARIABLES) {
+        program->symbols.resize(count);
+        for (auto& symbol : program->symbols) in.getString(symbol);
+    } else {
+        return nullptr;
+    }
+    if (in.get(count) && count <= MAX_OPS) {
+        program->strings.resize(count);
+        for (auto& text : program->strings) in.getString(text);
+    } else {
+        return nullptr;
+    }
+    in.get(program->loopDepth);
+    in.get(program->instructionCount);
+
+    if (!in.ok() || program->code.size() > MAX_OPS) return nullptr;
+
+    // Reject images whose operands would index past the register file
+    size_t vars = program->symbols.size();
+    size_t regs = program->registerCount();
+    size_t ops = program->code.size();
+    for (const auto& op : program->code) {
+        bool valid;
+        switch (op.code) {
+            case OpCode::PRINT:
+                valid = op.a < program->strings.size() && (!(op.flags & PRINT_VAR) || op.b < vars);
+                break;
+            case OpCode::DECLARE:
+            case OpCode::ADD:
+            case OpCode::SUBTRACT:
+                valid = op.dst < vars && ((op.flags & A_LITERAL) || op.a < vars)
+                        && ((op.flags & B_LITERAL) || op.b < vars);
+                break;
+            case OpCode::SLEEP:
+                valid = (op.flags & A_LITERAL) || op.a < vars;
+                break;
+            case OpCode::FOR_BEGIN:
+                valid = op.dst >= vars && op.dst < regs && op.b <= ops;
+                break;
+            case OpCode::LOOP_END:
+                valid = op.dst >= vars && op.dst < regs && op.a < ops;
+                break;
+            default:
+                valid = false;
+                break;
+        }
+        if (!valid) return nullptr;
+    }
+    return program;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <memory>
+
+class BinaryWriter;
+class BinaryReader;
+
+// Compact program image. Variables are resolved to register slots when the
+// program is built, so executing an instruction never touches a string or a
+// hash map. One image is shared by every process running the same script.
+enum class OpCode : uint8_t {
+    PRINT,      // strings[a], followed by register b if PRINT_VAR is set
+    DECLARE,    // dst = a
+    ADD,        // dst = a + b
+    SUBTRACT,   // dst = a - b
+    SLEEP,      // sleep for a ticks
+
+    // Loop control. These are not counted as executed instructions.
+    FOR_BEGIN,  // counter dst = a; if a == 0 jump to b (past the LOOP_END)
+    LOOP_END    // if --counter dst > 0 jump back to a (first op of the body)
+};
+
+struct Op {
+    OpCode code;
+    uint8_t flags;
+    uint16_t dst;
+    uint16_t a;
+    uint16_t b;
+};
+static_assert(sizeof(Op) == 8, "Op should stay 8 bytes");
+
+struct Program {
+    // Op::flags
+    static constexpr uint8_t A_LITERAL = 1 << 0; // a holds a value instead of a register
+    static constexpr uint8_t B_LITERAL = 1 << 1; // b holds a value instead of a register
+    static constexpr uint8_t PRINT_VAR = 1 << 2; // PRINT appends register b
+
+    static constexpr uint16_t MAX_VARIABLES = 32;
+    static constexpr uint16_t MAX_LOOP_DEPTH = 3;
+    static constexpr size_t MAX_OPS = 0xFFFF; // branch targets are 16-bit
+    static constexpr uint16_t NO_SLOT = 0xFFFF;
+
+    std::vector<Op> code;
+    std::vector<std::string> symbols; // register slot -> variable name
+    std::vector<std::string> strings; // PRINT message pool
+    uint16_t loopDepth = 0;           // loop counters live after the variables
+    uint64_t instructionCount = 0;    // instructions executed by one full run
+
+    // Returns the register slot of a variable, adding it if needed.
+    // Returns NO_SLOT once MAX_VARIABLES is reached.
+    uint16_t symbol(std::string_view name);
+    uint16_t addString(std::string_view text);
+
+    // Call once after code is complete. Loop ops are emitted with their
+    // nesting depth in dst; this moves them to their counter registers and
+    // computes instructionCount.
+    void finalize();
+
+    uint16_t registerCount() const;
+
+    void save(BinaryWriter& out) const;
+    static std::shared_ptr<Program> load(BinaryReader& in); // nullptr if corrupt
+};
@@ -0,0 +1,341 @@
+#include "ProgramParser.h"
+#include <cctype>
+#include <charconv>
+#include <functional>
+
+namespace {
+
+enum class TokenKind {
+    WORD, NUMBER, STRING, LPAREN, RPAREN, LBRACKET, RBRACKET, COMMA, SEMICOLON, PLUS, END, INVALID
+};
+
+struct Token {
+    TokenKind kind;
+    std::string_view text;
+};
+
+class Lexer {
+public:
+    explicit Lexer(std::string_view src) : src(src) {}
+
+    Token next() {
+        while (pos < src.size() && std::isspace(static_cast<unsigned char>(src[pos]))) pos++;
+        if (pos >= src.size()) return {TokenKind::END, std::string_view()};
+
+        char c = src[pos];
+        // Scripts typed inside a quoted CLI argument use \" for string literals
+        if (c == '"' || (c == '\\' && pos + 1 < src.size() && src[pos + 1] == '"')) {
+            return stringLiteral();
+        }
+        switch (c) {
+            case '(': return single(TokenKind::LPAREN);
+            case ')': return single(TokenKind::RPAREN);
+            case '[': return single(TokenKind::LBRACKET);
+            case ']': return single(TokenKind::RBRACKET);
+            case ',': return single(TokenKind::COMMA);
+            case ';': return single(TokenKind::SEMICOLON);
+            case '+': return single(TokenKind::PLUS);
+        }
+        if (std::isdigit(static_cast<unsigned char>(c))) {
+            return span(TokenKind::NUMBER, [](char ch) { return std::isdigit(static_cast<unsigned char>(ch)) != 0; });
+        }
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '_') {
+            return span(TokenKind::WORD, [](char ch) { return std::isalnum(static_cast<unsigned char>(ch)) != 0 || ch == '_'; });
+        }
+        return single(TokenKind::INVALID);
+    }
+
+    Token peek() {
+        size_t saved = pos;
+        Token token = next();
+        pos = saved;
+        return token;
+    }
+
+private:
+    std::string_view src;
+    size_t pos = 0;
+
+    Token single(TokenKind kind) {
+        return {kind, src.substr(pos++, 1)};
+    }
+
+    template <typename Pred>
+    Token span(TokenKind kind, Pred pred) {
+        size_t start = pos;
+        while (pos < src.size() && pred(src[pos])) pos++;
+        return {kind, src.substr(start, pos - start)};
+    }
+
+    Token stringLiteral() {
+        pos += (src[pos] == '\\') ? 2 : 1;
+        size_t start = pos;
+        while (pos < src.size() && src[pos] != '"') pos++;
+        if (pos >= src.size()) return {TokenKind::INVALID, src.substr(start - 1)};
+
+        size_t end = pos;
+        if (end > start && src[end - 1] == '\\') end--; // closing \"
+        pos++;
+        return {TokenKind::STRING, src.substr(start, end - start)};
+    }
+};
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(a[i])) != std::toupper(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class Parser {
+public:
+    Parser(std::string_view src, Program& program, std::string& error)
+        : lexer(src), program(program), error(error) {}
+
+    bool parse() {
+        return block(TokenKind::END);
+    }
+
+private:
+    Lexer lexer;
+    Program& program;
+    std::string& error;
+    uint16_t depth = 0; // FOR nesting level
+
+    // Statements up to and including terminator (END, or ']' for a FOR body)
+    bool block(TokenKind terminator) {
+        while (true) {
+            Token token = lexer.next();
+            if (token.kind == terminator) return true;
+            if (token.kind == TokenKind::SEMICOLON) continue;
+            if (!statement(token)) return false;
+
+            Token end = lexer.next();
+            if (end.kind == terminator) return true;
+            if (end.kind != TokenKind::SEMICOLON) return fail("Expected ';' between instructions", end);
+        }
+    }
+
+    bool emit(const Op& op, const Token& at) {
+        if (program.code.size() >= Program::MAX_OPS) return fail("Program is too long", at);
+        program.code.push_back(op);
+        return true;
+    }
+
+    bool fail(const char* message, const Token& token) {
+        error = message;
+        if (token.kind == TokenKind::END) {
+            error += " at end of input";
+        } else {
+            error += " near '";
+            error.append(token.text.data(), token.text.size());
+            error += "'";
+        }
+        return false;
+    }
+
+    bool accept(TokenKind kind) {
+        if (lexer.peek().kind != kind) return false;
+        lexer.next();
+        return true;
+    }
+
+    bool expect(TokenKind kind, const char* message) {
+        Token token = lexer.next();
+        return token.kind == kind || fail(message, token);
+    }
+
+    // Instructions may be written as DECLARE x 5 or DECLARE(x, 5)
+    void separator() {
+        accept(TokenKind::COMMA);
+    }
+
+    bool statement(const Token& keyword) {
+        if (keyword.kind != TokenKind::WORD) return fail("Expected an instruction", keyword);
+
+        bool parenthesized = accept(TokenKind::LPAREN);
+        bool ok;
+        if (equalsIgnoreCase(keyword.text, "PRINT")) ok = print();
+        else if (equalsIgnoreCase(keyword.text, "DECLARE")) ok = declare();
+        else if (equalsIgnoreCase(keyword.text, "ADD")) ok = arithmetic(OpCode::ADD);
+        else if (equalsIgnoreCase(keyword.text, "SUBTRACT")) ok = arithmetic(OpCode::SUBTRACT);
+        else if (equalsIgnoreCase(keyword.text, "SLEEP")) ok = sleep();
+        else if (equalsIgnoreCase(keyword.text, "FOR")) ok = forLoop(keyword);
+        else return fail("Unknown instruction", keyword);
+
+        if (!ok) return false;
+        return !parenthesized || expect(TokenKind::RPAREN, "Expected ')'");
+    }
+
+    bool number(const Token& token, uint16_t& value) {
+        unsigned long parsed = 0;
+        auto result = std::from_chars(token.text.data(), token.text.data() + token.text.size(), parsed);
+        if (result.ec != std::errc() || parsed > 0xFFFF) return fail("Value out of range", token);
+        value = static_cast<uint16_t>(parsed);
+        return true;
+    }
+
+    bool variable(uint16_t& slot) {
+        Token token = lexer.next();
+        if (token.kind != TokenKind::WORD) return fail("Expected a variable", token);
+        slot = program.symbol(token.text);
+        return slot != Program::NO_SLOT || fail("Too many variables", token);
+    }
+
+    // A variable or a literal; sets flag in flags when it is a literal
+    bool operand(uint16_t& value, uint8_t& flags, uint8_t flag) {
+        Token token = lexer.peek();
+        if (token.kind == TokenKind::NUMBER) {
+            lexer.next();
+            flags |= flag;
+            return number(token, value);
+        }
+        return variable(value);
+    }
+
+    bool print() {
+        Op op{OpCode::PRINT, 0, 0, 0, 0};
+        Token message = lexer.next();
+        if (message.kind != TokenKind::STRING) return fail("Expected a string", message);
+        op.a = program.addString(message.text);
+
+        if (accept(TokenKind::PLUS)) {
+            if (!variable(op.b)) return false;
+            op.flags |= Program::PRINT_VAR;
+        }
+        return emit(op, message);
+    }
+
+    bool declare() {
+        Op op{OpCode::DECLARE, Program::A_LITERAL, 0, 0, 0};
+        if (!variable(op.dst)) return false;
+        separator();
+        Token value = lexer.next();
+        if (value.kind != TokenKind::NUMBER) return fail("Expected a value", value);
+        return number(value, op.a) && emit(op, value);
+    }
+
+    bool arithmetic(OpCode code) {
+        Op op{code, 0, 0, 0, 0};
+        Token at = lexer.peek();
+        if (!variable(op.dst)) return false;
+        separator();
+        if (!operand(op.a, op.flags, Program::A_LITERAL)) return false;
+        separator();
+        if (!operand(op.b, op.flags, Program::B_LITERAL)) return false;
+        return emit(op, at);
+    }
+
+    bool sleep() {
+        Op op{OpCode::SLEEP, Program::A_LITERAL, 0, 0, 0};
+        Token ticks = lexer.next();
+        if (ticks.kind != TokenKind::NUMBER) return fail("Expected a tick count", ticks);
+        if (!number(ticks, op.a)) return false;
+        if (op.a > 0xFF) return fail("Sleep is limited to 255 ticks", ticks);
+        return emit(op, ticks);
+    }
+
+    // FOR([body], repeats) compiles to
+    //   FOR_BEGIN counter=repeats, exit=after LOOP_END
+    //   body...
+    //   LOOP_END  counter, back to body
+    bool forLoop(const Token& keyword) {
+        if (depth >= Program::MAX_LOOP_DEPTH) return fail("FOR loops nest at most 3 deep", keyword);
+        if (!expect(TokenKind::LBRACKET, "Expected '[' to start the FOR body")) return false;
+
+        size_t begin = program.code.size();
+        if (!emit({OpCode::FOR_BEGIN, Program::A_LITERAL, depth, 0, 0}, keyword)) return false;
+
+        depth++;
+        bool ok = block(TokenKind::RBRACKET);
+        depth--;
+        if (!ok) return false;
+        if (program.code.size() == begin + 1) return fail("FOR body is empty", keyword);
+
+        separator();
+        Token repeats = lexer.next();
+        if (repeats.kind != TokenKind::NUMBER) return fail("Expected a repeat count", repeats);
+        if (!number(repeats, program.code[begin].a)) return false;
+
+        Op loopEnd{OpCode::LOOP_END, 0, depth, static_cast<uint16_t>(begin + 1), 0};
+        if (!emit(loopEnd, repeats)) return false;
+        program.code[begin].b = static_cast<uint16_t>(program.code.size());
+        return true;
+    }
+};
+
+} // namespace
+
+std::shared_ptr<const Program> ProgramParser::compile(std::string_view source, std::string& error) {
+    auto program = std::make_shared<Program>();
+    Parser parser(source, *program, error);
+    if (!parser.parse()) return nullptr;
+
+    if (program->code.empty()) {
+        error = "Program has no instructions";
+        return nullptr;
+    }
+    program->code.shrink_to_fit();
+    program->finalize();
+    return program;
+}
+
+ProgramCache* ProgramCache::instance = nullptr;
+
+ProgramCache* ProgramCache::getInstance() {
+    if (!instance) {
+        instance = new ProgramCache();
+    }
+    return instance;
+}
+
+ProgramCache::ProgramCache() {}
+
+std::shared_ptr<const Program> ProgramCache::get(std::string_view source, std::string& error) {
+    size_t key = std::hash<std::string_view>{}(source);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it != entries.end() && it->second->source == source) {
+            hits++;
+            recent.splice(recent.begin(), recent, it->second);
+            return it->second->program;
+        }
+        misses++;
+    }
+
+    auto program = ProgramParser::compile(source, error);
+    if (!program) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        // Compiled twice at once, or a hash collision: the newest wins
+        recent.erase(it->second);
+        entries.erase(it);
+    } else if (entries.size() >= MAX_ENTRIES) {
+        entries.erase(recent.back().key);
+        recent.pop_back();
+    }
+    recent.push_front(Entry{key, std::string(source), program});
+    entries[key] = recent.begin();
+    return program;
+}
+
+size_t ProgramCache::getHits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+size_t ProgramCache::getMisses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
+
+size_t ProgramCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
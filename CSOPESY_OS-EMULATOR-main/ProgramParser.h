@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include "Program.h"
+
+class ProgramParser {
+public:
+    // Compiles a ';' separated user script, e.g.
+    //   DECLARE varA 10; ADD varA varA 5; PRINT("Result: " + varA)
+    // Tokens are views into source, nothing is allocated per token.
+    // Returns nullptr and sets error if the script is invalid.
+    static std::shared_ptr<const Program> compile(std::string_view source, std::string& error);
+};
+
+// Compiled programs keyed by the hash of their source, so resubmitting the
+// same script skips the parser and shares the program image. When full, the
+// least recently used entry makes room.
+class ProgramCache {
+public:
+    static ProgramCache* getInstance();
+
+    std::shared_ptr<const Program> get(std::string_view source, std::string& error);
+
+    size_t getHits() const;
+    size_t getMisses() const;
+    size_t size() const;
+
+private:
+    ProgramCache();
+    static ProgramCache* instance;
+
+    static constexpr size_t MAX_ENTRIES = 4096;
+
+    struct Entry {
+        size_t key;
+        std::string source; // guards against hash collisions
+        std::shared_ptr<const Program> program;
+    };
+
+    mutable std::mutex mutex;
+    std::list<Entry> recent; // most recently used first
+    std::unordered_map<size_t, std::list<Entry>::iterator> entries;
+    size_t hits = 0;
+    size_t misses = 0;
+};
@@ -0,0 +1,160 @@
+#include "Report.h"
+#include <fstream>
+#include "BinaryIO.h"
+#include "LocalTime.h"
+
+namespace {
+
+const size_t chunkSize = 1 << 20;
+const char reportMagic[8] = {'C', 'S', 'O', 'P', 'R', 'E', 'P', 'T'};
+const uint32_t reportVersion = 1;
+
+const char* stateName(Process::ProcessState state) {
+    switch (state) {
+        case Process::READY: return "READY";
+        case Process::RUNNING: return "RUNNING";
+        case Process::WAITING: return "WAITING";
+        case Process::FINISHED: return "FINISHED";
+    }
+    return "UNKNOWN";
+}
+
+// Quotes names that would break a CSV row
+void appendCsvField(std::string& out, const std::string& field) {
+    if (field.find_first_of(",\"\n") == std::string::npos) {
+        out += field;
+        return;
+    }
+    out += '"';
+    for (char c : field) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+} // namespace
+
+bool Report::parseFormat(std::string_view name, Format& format) {
+    if (name == "txt") format = TEXT;
+    else if (name == "csv") format = CSV;
+    else if (name == "bin") format = BINARY;
+    else return false;
+    return true;
+}
+
+const char* Report::defaultPath(Format format) {
+    switch (format) {
+        case CSV: return "csopesy-log.csv";
+        case BINARY: return "csopesy-log.bin";
+        default: return "csopesy-log.txt";
+    }
+}
+
+void Report::reserve(size_t count) {
+    rows.reserve(count);
+}
+
+void Report::add(const Process& process) {
+    rows.push_back(Row{process.getPID(), process.getName(), process.getState(), process.getCoreID(),
+                       process.getCommandCounter(), process.getLinesOfCode(), process.isFinished(),
+                       process.getFinishTime()});
+}
+
+void Report::setSummary(std::string text) {
+    summary = std::move(text);
+}
+
+size_t Report::size() const {
+    return rows.size();
+}
+
+bool Report::write(const std::string& path, Format format, std::atomic<size_t>& progress, uint64_t& bytes) const {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    bytes = 0;
+
+    std::string text;
+    BinaryWriter binary;
+    text.reserve(chunkSize + 256);
+    binary.reserve(chunkSize + 256);
+    auto flush = [&](size_t written) {
+        if (format == BINARY) {
+            file.write(binary.data().data(), binary.size());
+            bytes += binary.size();
+            binary.clear();
+        } else {
+            file.write(text.data(), text.size());
+            bytes += text.size();
+            text.clear();
+        }
+        progress.store(written, std::memory_order_relaxed);
+    };
+
+    if (format == TEXT) {
+        text += "=== CPU Utilization Report ===\n";
+    } else if (format == CSV) {
+        text += "pid,name,state,core,executed,total,finish_time\n";
+    } else {
+        binary.put(reportMagic);
+        binary.put(reportVersion);
+        binary.put(static_cast<uint64_t>(rows.size()));
+    }
+
+    // Finish times repeat a lot, so format each distinct second only once
+    std::time_t cachedTime = -1;
+    char cachedText[32] = "";
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const Row& row = rows[i];
+        if (format == TEXT) {
+            text += "Process: ";
+            text += row.name;
+            text += " PID: " + std::to_string(row.pid) + " Progress: " + std::to_string(row.executed) + " / "
+                  + std::to_string(row.total);
+            if (row.finished) {
+                if (row.finishTime == -1) {
+                    text += " [N/A]";
+                } else {
+                    if (row.finishTime != cachedTime) {
+                        std::tm local = toLocalTime(row.finishTime);
+                        std::strftime(cachedText, sizeof(cachedText), "%H:%M:%S %m/%d/%Y", &local);
+                        cachedTime = row.finishTime;
+                    }
+                    text += " [";
+                    text += cachedText;
+                    text += "]";
+                }
+            }
+            text += '\n';
+        } else if (format == CSV) {
+            text += std::to_string(row.pid);
+            text += ',';
+            appendCsvField(text, row.name);
+            text += ',';
+            text += stateName(row.state);
+            text += ',' + std::to_string(row.core) + ',' + std::to_string(row.executed) + ','
+                  + std::to_string(row.total) + ',';
+            if (row.finished && row.finishTime != -1) text += std::to_string(static_cast<int64_t>(row.finishTime));
+            text += '\n';
+        } else {
+            binary.put(static_cast<int32_t>(row.pid));
+            binary.putString(row.name);
+            binary.put(static_cast<uint8_t>(row.state));
+            binary.put(static_cast<int32_t>(row.core));
+            binary.put(row.executed);
+            binary.put(row.total);
+            binary.put(static_cast<int64_t>(row.finished ? row.finishTime : -1));
+        }
+
+        if (text.size() >= chunkSize || binary.size() >= chunkSize) flush(i + 1);
+    }
+
+    if (format == TEXT && !summary.empty()) {
+        text += '\n';
+        text += summary;
+    }
+    flush(rows.size());
+    file.close();
+    return static_cast<bool>(file);
+}
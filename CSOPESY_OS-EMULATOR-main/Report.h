@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Process.h"
+
+// Snapshot of every process for report-util. Taking it is a plain copy
+// under the state lock; formatting and writing happen later on another
+// thread, streamed through a large buffer.
+class Report {
+public:
+    enum Format { TEXT, CSV, BINARY };
+
+    static bool parseFormat(std::string_view name, Format& format); // txt, csv or bin
+    static const char* defaultPath(Format format);
+
+    void reserve(size_t count);
+    void add(const Process& process);
+    void setSummary(std::string text); // vmstat section, text reports only
+    size_t size() const;
+
+    // progress counts the processes written so far
+    bool write(const std::string& path, Format format, std::atomic<size_t>& progress, uint64_t& bytes) const;
+
+private:
+    struct Row {
+        int pid;
+        std::string name;
+        Process::ProcessState state;
+        int core;
+        uint64_t executed;
+        uint64_t total;
+        bool finished;
+        std::time_t finishTime; // -1 when the finish time is unknown
+    };
+
+    std::vector<Row> rows;
+    std::string summary;
+};
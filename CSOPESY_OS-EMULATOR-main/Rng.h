@@ -0,0 +1,76 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+
+// xoshiro256** generator. A few shifts and multiplies per number, so it
+// can be called per generated instruction. Not thread-safe: give each
+// thread its own stream. Streams with the same seed are reproducible.
+// Trivially copyable, so checkpoints store the state as it is.
+class Rng {
+public:
+    explicit Rng(uint64_t seed = 0, uint64_t stream = 0) {
+        reseed(seed, stream);
+    }
+
+    void reseed(uint64_t seed, uint64_t stream = 0) {
+        // splitmix64 spreads even small or similar seeds over the whole state
+        uint64_t x = seed ^ (stream * 0xD1B54A32D192ED03ULL);
+        for (auto& word : state) {
+            x += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = x;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, bound), without modulo bias (Lemire's method)
+    uint32_t below(uint32_t bound) {
+        if (bound == 0) return 0;
+        uint64_t product = (next() >> 32) * bound;
+        uint32_t low = static_cast<uint32_t>(product);
+        if (low < bound) {
+            uint32_t threshold = static_cast<uint32_t>(-bound) % bound;
+            while (low < threshold) {
+                product = (next() >> 32) * bound;
+                low = static_cast<uint32_t>(product);
+            }
+        }
+        return static_cast<uint32_t>(product >> 32);
+    }
+
+    // Uniform in [low, high]
+    int between(int low, int high) {
+        if (high <= low) return low;
+        return low + static_cast<int>(below(static_cast<uint32_t>(high - low) + 1));
+    }
+
+    // Uniform in [0, 1)
+    double uniform() {
+        return (next() >> 11) * 0x1.0p-53;
+    }
+
+    // Exponentially distributed with the given mean
+    double exponential(double mean) {
+        return -mean * std::log1p(-uniform());
+    }
+
+private:
+    uint64_t state[4];
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
@@ -1,49 +1,182 @@
 #include "Scheduler.h"
 #include <iostream>
 #include <cstdint>
+#include <iomanip>
+#include <algorithm>
 
-Scheduler::Scheduler(int numCores, const std::string& algorithm, int quantum, int delay)
-    : numCores(numCores), schedulingAlgorithm(algorithm), quantum(quantum), isRunning(true), delayPerExec(delay){
+Scheduler::Scheduler(int numCores, const std::string& algorithm, int quantum, int delay, size_t memorySize)
+    : numCores(numCores), schedulingAlgorithm(algorithm), quantum(quantum), delayPerExec(delay), isRunning(true){
     cores.resize(numCores);
+    if (memorySize > 0) {
+        memory = std::make_unique<MemoryManager>(memorySize);
+    }
 }
 
 void Scheduler::addProcess(std::shared_ptr<Process> process) {
+    process->setLastScheduledTick(tickCount);
+    process->getTiming().arrival = tickCount;
+    // Never jump ahead of processes already waiting for memory
+    if (pendingQueue.empty() && admit(process)) {
+        makeReady(process);
+    } else {
+        process->setState(Process::WAITING);
+        pendingQueue.push(process);
+    }
+}
+
+bool Scheduler::admit(const std::shared_ptr<Process>& process) {
+    if (!memory || process->getMemorySize() <= 0) return true;
+
+    size_t address = memory->allocate(process->getMemorySize());
+    if (address == MemoryManager::NO_BLOCK && makeRoom(process->getMemorySize())) {
+        address = memory->allocate(process->getMemorySize());
+    }
+    if (address == MemoryManager::NO_BLOCK) return false;
+    process->setMemoryAddress(address);
+    return true;
+}
+
+void Scheduler::admitPending() {
+    while (!pendingQueue.empty() && admit(pendingQueue.front())) {
+        makeReady(pendingQueue.front());
+        pendingQueue.pop();
+    }
+}
+
+void Scheduler::release(Process& process) {
+    if (memory && process.getMemoryAddress() != Process::NO_MEMORY) {
+        memory->free(process.getMemoryAddress());
+        process.setMemoryAddress(Process::NO_MEMORY);
+    }
+}
+
+void Scheduler::makeReady(const std::shared_ptr<Process>& process) {
     process->setState(Process::READY);
-    readyQueue.push(process);
+    process->getTiming().readySince = tickCount;
+    readyQueue.push_back(process);
+    if (!process->isSwapped() && process->getMemoryAddress() != Process::NO_MEMORY) {
+        swapCandidates.emplace(process->getLastScheduledTick(), process.get());
+    }
+}
+
+// Swaps out the least recently scheduled READY processes until size fits
+bool Scheduler::makeRoom(size_t size) {
+    if (!swapper) return false;
+    while (!memory->canAllocate(size) && !swapCandidates.empty()) {
+        Process* victim = swapCandidates.begin()->second;
+        swapCandidates.erase(swapCandidates.begin());
+        if (!swapper->swapOut(*victim)) return false;
+        release(*victim);
+    }
+    return memory->canAllocate(size);
+}
+
+// A dispatched process needs its memory and its swapped-out state back
+Scheduler::Residency Scheduler::makeResident(const std::shared_ptr<Process>& process) {
+    if (memory && process->getMemorySize() > 0 && process->getMemoryAddress() == Process::NO_MEMORY
+        && !admit(process)) {
+        return Residency::NO_MEMORY;
+    }
+    if (process->isSwapped() && !(swapper && swapper->swapIn(*process))) {
+        if (failedSwapIns.insert(process->getPID()).second) {
+            std::cerr << "Failed to swap in " << process->getName() << " from the backing store, will retry.\n";
+        }
+        return Residency::SWAP_FAILED;
+    }
+    failedSwapIns.erase(process->getPID());
+    return Residency::RESIDENT;
+}
+
+bool Scheduler::enableSwapping(const std::string& backingStore, int depth) {
+    if (!memory) return false;
+    swapper = std::make_unique<Swapper>(backingStore, depth > 0);
+    if (!swapper->isOpen()) {
+        swapper.reset();
+        return false;
+    }
+    prefetchDepth = depth;
+    return true;
 }
 
 void Scheduler::tick() {
     if (!isRunning) return;
+    tickCount++;
     assignProcessesToCores();
     executeProcesses();
 }
 
 void Scheduler::assignProcessesToCores() {
+    // Free the memory of finished processes first so waiting ones can be admitted
+    for (auto& core : cores) {
+        if (core.currentProcess && core.currentProcess->isFinished()) {
+            core.currentProcess->setState(Process::FINISHED);
+            release(*core.currentProcess);
+            core.currentProcess = nullptr;
+        }
+    }
+    admitPending();
+    queueLengthSum += readyQueue.size();
+    maxQueueLength = std::max(maxQueueLength, readyQueue.size());
+    queueHistory[tickCount % QUEUE_HISTORY] = static_cast<uint32_t>(readyQueue.size());
+    if (tracer) trace(tracer->schedulerTrack(), Tracer::QUEUE_DEPTH, 0, static_cast<uint32_t>(readyQueue.size()));
+
+    std::vector<std::shared_ptr<Process>> retries;
     for (int i = 0; i < numCores; ++i) {
         auto& core = cores[i];
-        if (!core.currentProcess || core.currentProcess->isFinished()) {
-            if (core.currentProcess && core.currentProcess->isFinished()) {
-                core.currentProcess->setState(Process::FINISHED);
-                core.currentProcess = nullptr;
-            }
-
+        if (!core.currentProcess) {
             if (!readyQueue.empty()) {
                 auto nextProcess = readyQueue.front();
-                readyQueue.pop();
+                Residency residency = makeResident(nextProcess);
+                // Memory is held by running processes, try again next tick
+                if (residency == Residency::NO_MEMORY) break;
+
+                readyQueue.pop_front();
+                swapCandidates.erase({nextProcess->getLastScheduledTick(), nextProcess.get()});
+                if (residency == Residency::SWAP_FAILED) {
+                    // Give back its block and let the rest of the queue run; it is retried from the back
+                    release(*nextProcess);
+                    retries.push_back(nextProcess);
+                    continue;
+                }
                 nextProcess->setCoreID(i);
                 nextProcess->setState(Process::RUNNING);
+                nextProcess->setLastScheduledTick(tickCount);
+                auto& timing = nextProcess->getTiming();
+                timing.waited += tickCount - timing.readySince;
+                if (timing.firstRun == Process::Timing::NOT_YET) timing.firstRun = tickCount;
                 core.currentProcess = nextProcess;
                 core.remainingQuantum = quantum;
+                core.dispatches++;
+                trace(i, Tracer::DISPATCH, nextProcess->getPID());
             }
         }
     }
+    readyQueue.insert(readyQueue.end(), retries.begin(), retries.end());
+
+    if (swapper) {
+        int lookahead = 0;
+        for (auto it = readyQueue.begin(); it != readyQueue.end() && lookahead < prefetchDepth; ++it, ++lookahead) {
+            if ((*it)->isSwapped()) swapper->prefetch(**it);
+        }
+    }
 }
 
 void Scheduler::executeProcesses() {
     for (int i = 0; i < numCores; ++i) {
         auto& core = cores[i];
         if (core.currentProcess && !core.currentProcess->isFinished()) {
+            uint64_t executed = core.currentProcess->getCommandCounter();
+            bool wasSleeping = core.currentProcess->isSleeping();
             core.currentProcess->executeNextInstruction(i);
+            core.instructions += core.currentProcess->getCommandCounter() - executed;
+            core.busyTicks++;
+            if (!wasSleeping && core.currentProcess->isSleeping()) {
+                trace(i, Tracer::SLEEP, core.currentProcess->getPID(), core.currentProcess->getSleepTicks());
+            }
+            if (core.currentProcess->isFinished()) {
+                recordFinish(*core.currentProcess);
+                trace(i, Tracer::FINISH, core.currentProcess->getPID());
+            }
 
             if(delayPerExec > 0){
                 volatile uint64_t busy = 0;
@@ -58,15 +191,26 @@ void Scheduler::executeProcesses() {
 
                 if (core.remainingQuantum <= 0 && !core.currentProcess->isFinished()) {
                     // Preempt and requeue
-                    core.currentProcess->setState(Process::READY);
-                    readyQueue.push(core.currentProcess);
+                    trace(i, Tracer::PREEMPT, core.currentProcess->getPID());
+                    makeReady(core.currentProcess);
                     core.currentProcess = nullptr;
+                    core.preemptions++;
                 }
             }
+        } else {
+            core.idleTicks++;
         }
     }
 }
 
+void Scheduler::recordFinish(Process& process) {
+    auto& timing = process.getTiming();
+    timing.finish = tickCount;
+    waitTimes.record(timing.waited);
+    turnaroundTimes.record(timing.finish - timing.arrival);
+    responseTimes.record(timing.firstRun - timing.arrival);
+}
+
 void Scheduler::stop() {
     isRunning = false;
 }
@@ -88,3 +232,243 @@ int Scheduler::getAvailableCores() const {
     }
     return count;
 }
+
+size_t Scheduler::getPendingCount() const {
+    return pendingQueue.size();
+}
+
+const MemoryManager* Scheduler::getMemory() const {
+    return memory.get();
+}
+
+Swapper* Scheduler::getSwapper() const {
+    return swapper.get();
+}
+
+uint64_t Scheduler::getTickCount() const {
+    return tickCount;
+}
+
+namespace {
+
+void writeHistogram(std::ostream& out, const char* name, const Histogram& histogram) {
+    out << "  " << std::left << std::setw(12) << name << std::right
+        << " count " << std::setw(7) << histogram.getCount()
+        << "  mean " << std::setw(8) << std::fixed << std::setprecision(1) << histogram.getMean()
+        << "  p50 <= " << std::setw(6) << histogram.percentile(50)
+        << "  p90 <= " << std::setw(6) << histogram.percentile(90)
+        << "  p99 <= " << std::setw(6) << histogram.percentile(99)
+        << "  max " << histogram.getMax() << "\n";
+}
+
+double percentOf(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * part / whole : 0.0;
+}
+
+} // namespace
+
+Scheduler::Core Scheduler::totalCounters() const {
+    Core total = removedCores;
+    for (const auto& core : cores) {
+        total.busyTicks += core.busyTicks;
+        total.idleTicks += core.idleTicks;
+        total.instructions += core.instructions;
+        total.dispatches += core.dispatches;
+        total.preemptions += core.preemptions;
+    }
+    return total;
+}
+
+Scheduler::Summary Scheduler::getSummary() const {
+    Core total = totalCounters();
+    return Summary{tickCount, total.instructions, total.dispatches, total.preemptions, total.busyTicks,
+                   total.idleTicks, turnaroundTimes.getCount(), waitTimes.getMean(), turnaroundTimes.getMean(),
+                   turnaroundTimes.percentile(90), responseTimes.getMean()};
+}
+
+Scheduler::Metrics Scheduler::getMetrics() const {
+    auto counters = [](const Core& core) {
+        return Metrics::Counters{core.busyTicks, core.idleTicks, core.instructions, core.dispatches, core.preemptions};
+    };
+
+    Metrics metrics;
+    metrics.ticks = tickCount;
+    metrics.total = counters(totalCounters());
+    for (const auto& core : cores) metrics.cores.push_back(counters(core));
+    metrics.readyQueueLength = readyQueue.size();
+    metrics.meanQueueLength = tickCount ? static_cast<double>(queueLengthSum) / tickCount : 0.0;
+    metrics.maxQueueLength = maxQueueLength;
+    uint64_t samples = std::min<uint64_t>(tickCount, QUEUE_HISTORY);
+    for (uint64_t t = tickCount - samples + 1; t <= tickCount; ++t) {
+        metrics.recentQueueLengths.push_back(queueHistory[t % QUEUE_HISTORY]);
+    }
+    metrics.waitTimes = waitTimes;
+    metrics.turnaroundTimes = turnaroundTimes;
+    metrics.responseTimes = responseTimes;
+    return metrics;
+}
+
+void Scheduler::writeMetrics(std::ostream& out) const {
+    writeMetrics(out, getMetrics());
+}
+
+void Scheduler::writeMetrics(std::ostream& out, const Metrics& metrics) {
+    const auto& total = metrics.total;
+
+    out << "=== CPU ===\n";
+    out << "Ticks: " << metrics.ticks << "\n";
+    out << "Instructions executed: " << total.instructions << "\n";
+    out << "Context switches: " << total.dispatches << " (" << total.preemptions << " preemptions)\n";
+    out << "CPU utilization: " << std::fixed << std::setprecision(1)
+        << percentOf(total.busyTicks, total.busyTicks + total.idleTicks) << "%\n";
+    for (size_t i = 0; i < metrics.cores.size(); ++i) {
+        const auto& core = metrics.cores[i];
+        out << "  Core " << i << ": busy " << core.busyTicks << ", idle " << core.idleTicks
+            << " (" << std::fixed << std::setprecision(1) << percentOf(core.busyTicks, core.busyTicks + core.idleTicks)
+            << "%), " << core.instructions << " instructions, " << core.dispatches << " dispatches, "
+            << core.preemptions << " preemptions\n";
+    }
+
+    out << "Ready queue length: now " << metrics.readyQueueLength << ", mean " << std::fixed << std::setprecision(1)
+        << metrics.meanQueueLength << ", max " << metrics.maxQueueLength << "\n";
+    out << "  Last " << QUEUE_HISTORY << " ticks:";
+    for (uint32_t length : metrics.recentQueueLengths) {
+        out << " " << length;
+    }
+    out << "\n";
+
+    out << "\n=== Finished Process Latency (ticks) ===\n";
+    writeHistogram(out, "Wait", metrics.waitTimes);
+    writeHistogram(out, "Turnaround", metrics.turnaroundTimes);
+    writeHistogram(out, "Response", metrics.responseTimes);
+    out.unsetf(std::ios::floatfield);
+}
+
+void Scheduler::setTracer(Tracer* newTracer) {
+    tracer = newTracer;
+}
+
+int Scheduler::getNumCores() const {
+    return numCores;
+}
+
+void Scheduler::setNumCores(int count) {
+    for (int i = count; i < numCores; ++i) {
+        removedCores.busyTicks += cores[i].busyTicks;
+        removedCores.idleTicks += cores[i].idleTicks;
+        removedCores.instructions += cores[i].instructions;
+        removedCores.dispatches += cores[i].dispatches;
+        removedCores.preemptions += cores[i].preemptions;
+
+        auto& process = cores[i].currentProcess;
+        if (process && process->isFinished()) {
+            // Not reaped by assignProcessesToCores() yet, so free its memory here
+            process->setState(Process::FINISHED);
+            release(*process);
+        } else if (process) {
+            trace(i, Tracer::MIGRATE, process->getPID());
+            process->setCoreID(-1);
+            makeReady(process);
+        }
+    }
+    numCores = count;
+    cores.resize(count);
+}
+
+void Scheduler::save(BinaryWriter& out) const {
+    out.put(static_cast<uint32_t>(cores.size()));
+    for (const auto& core : cores) {
+        out.put(static_cast<int32_t>(core.currentProcess ? core.currentProcess->getPID() : -1));
+        out.put(static_cast<int32_t>(core.remainingQuantum));
+        saveCounters(out, core);
+    }
+    saveCounters(out, removedCores);
+
+    out.put(static_cast<uint32_t>(readyQueue.size()));
+    for (const auto& process : readyQueue) {
+        out.put(static_cast<int32_t>(process->getPID()));
+    }
+
+    std::queue<std::shared_ptr<Process>> pending = pendingQueue;
+    out.put(static_cast<uint32_t>(pending.size()));
+    while (!pending.empty()) {
+        out.put(static_cast<int32_t>(pending.front()->getPID()));
+        pending.pop();
+    }
+
+    out.put(static_cast<uint8_t>(memory != nullptr));
+    if (memory) memory->save(out);
+    out.put(tickCount);
+
+    out.put(queueLengthSum);
+    out.put(static_cast<uint64_t>(maxQueueLength));
+    out.put(queueHistory);
+    out.put(waitTimes);
+    out.put(turnaroundTimes);
+    out.put(responseTimes);
+}
+
+void Scheduler::saveCounters(BinaryWriter& out, const Core& core) {
+    out.put(core.busyTicks);
+    out.put(core.idleTicks);
+    out.put(core.instructions);
+    out.put(core.dispatches);
+    out.put(core.preemptions);
+}
+
+bool Scheduler::loadCounters(BinaryReader& in, Core& core) {
+    in.get(core.busyTicks);
+    in.get(core.idleTicks);
+    in.get(core.instructions);
+    in.get(core.dispatches);
+    return in.get(core.preemptions);
+}
+
+bool Scheduler::load(BinaryReader& in, const std::function<std::shared_ptr<Process>(int)>& findProcess) {
+    uint32_t coreCount = 0;
+    if (!in.get(coreCount) || coreCount != cores.size()) return false;
+    for (auto& core : cores) {
+        int32_t pid = -1, remaining = 0;
+        in.get(pid);
+        in.get(remaining);
+        core.currentProcess = (pid >= 0) ? findProcess(pid) : nullptr;
+        core.remainingQuantum = remaining;
+        if (pid >= 0 && !core.currentProcess) return false;
+        if (!loadCounters(in, core)) return false;
+    }
+    if (!loadCounters(in, removedCores)) return false;
+
+    std::vector<std::shared_ptr<Process>> restored[2];
+    for (auto& queue : restored) {
+        uint32_t queued = 0;
+        in.get(queued);
+        for (uint32_t i = 0; i < queued && in.ok(); ++i) {
+            int32_t pid = -1;
+            in.get(pid);
+            auto process = findProcess(pid);
+            if (!process) return false;
+            queue.push_back(process);
+        }
+    }
+
+    uint8_t hasMemory = 0;
+    if (!in.get(hasMemory) || hasMemory != (memory != nullptr)) return false;
+    if (memory && !memory->load(in)) return false;
+    if (!in.get(tickCount)) return false;
+
+    uint64_t maxLength = 0;
+    in.get(queueLengthSum);
+    in.get(maxLength);
+    in.get(queueHistory);
+    in.get(waitTimes);
+    in.get(turnaroundTimes);
+    if (!in.get(responseTimes)) return false;
+    maxQueueLength = static_cast<size_t>(maxLength);
+
+    readyQueue.clear();
+    swapCandidates.clear();
+    for (const auto& process : restored[0]) makeReady(process);
+    pendingQueue = std::queue<std::shared_ptr<Process>>();
+    for (const auto& process : restored[1]) pendingQueue.push(process);
+    return true;
+}
@@ -2,22 +2,102 @@
 
 #include <vector>
 #include <queue>
+#include <deque>
+#include <set>
+#include <array>
+#include <ostream>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <functional>
 #include "Process.h"
+#include "BinaryIO.h"
+#include "MemoryManager.h"
+#include "Swapper.h"
+#include "Histogram.h"
+#include "Tracer.h"
 
 class Scheduler {
 public:
-    Scheduler(int numCores, const std::string& algorithm, int quantum = 1, int delay = 0);
+    // memorySize = 0 disables admission control
+    Scheduler(int numCores, const std::string& algorithm, int quantum = 1, int delay = 0, size_t memorySize = 0);
 
+    // Admits the process to the ready queue if its memory can be allocated,
+    // otherwise it waits (WAITING) in the pending queue until memory frees up
+    // The process's memory must fit in the whole memory (the shell checks
+    // sizes against it), or it would hold up every process queued behind it
     void addProcess(std::shared_ptr<Process> process);
+
+    // Under memory pressure, swap the least recently scheduled READY
+    // processes to the backing store and prefetch the next prefetchDepth
+    // swapped processes in the ready queue. Needs admission control.
+    bool enableSwapping(const std::string& backingStore, int prefetchDepth);
     void tick(); // Simulates one CPU cycle
     void stop(); // Stops the scheduler loop
     void resume(); // Resumes the scheduler loop
 
     std::string getAlgorithm() const;
     int getAvailableCores() const;
+    int getNumCores() const;
+    size_t getPendingCount() const;
+    const MemoryManager* getMemory() const; // nullptr without admission control
+    Swapper* getSwapper() const; // nullptr unless swapping is enabled
+    uint64_t getTickCount() const;
+
+    // Per-core utilization, context switches, ready queue length and
+    // wait/turnaround/response histograms of finished processes
+    void writeMetrics(std::ostream& out) const;
+
+    // A copy of those metrics, so they can be formatted off the tick thread
+    struct Metrics {
+        struct Counters {
+            uint64_t busyTicks = 0;
+            uint64_t idleTicks = 0;
+            uint64_t instructions = 0;
+            uint64_t dispatches = 0;
+            uint64_t preemptions = 0;
+        };
+        uint64_t ticks = 0;
+        Counters total; // including removed cores
+        std::vector<Counters> cores;
+        size_t readyQueueLength = 0;
+        double meanQueueLength = 0;
+        size_t maxQueueLength = 0;
+        std::vector<uint32_t> recentQueueLengths; // oldest first
+        Histogram waitTimes;
+        Histogram turnaroundTimes;
+        Histogram responseTimes;
+    };
+    Metrics getMetrics() const;
+    static void writeMetrics(std::ostream& out, const Metrics& metrics);
+
+    // The same metrics as numbers, for comparing runs side by side
+    struct Summary {
+        uint64_t ticks;
+        uint64_t instructions;
+        uint64_t dispatches;
+        uint64_t preemptions;
+        uint64_t busyTicks;
+        uint64_t idleTicks;
+        uint64_t finished;
+        double meanWait;
+        double meanTurnaround;
+        uint64_t p90Turnaround;
+        double meanResponse;
+    };
+    Summary getSummary() const;
+
+    // Grows or shrinks the core pool between ticks. Processes running on
+    // removed cores go back to the ready queue with their progress intact.
+    void setNumCores(int count);
+
+    // Scheduling events go to tracer while it is enabled; nullptr detaches
+    void setTracer(Tracer* tracer);
+
+    // Checkpoint support: core assignments, ready and pending queue order
+    // (by PID), the allocator state and the metrics
+    void save(BinaryWriter& out) const;
+    bool load(BinaryReader& in, const std::function<std::shared_ptr<Process>(int)>& findProcess);
 
 private:
     int numCores;
@@ -28,13 +108,55 @@ private:
     struct Core {
         std::shared_ptr<Process> currentProcess = nullptr;
         int remainingQuantum = 0;
+
+        // Counters, only touched by the tick thread
+        uint64_t busyTicks = 0;
+        uint64_t idleTicks = 0;
+        uint64_t instructions = 0;
+        uint64_t dispatches = 0;  // context switches onto this core
+        uint64_t preemptions = 0; // quantum expiries
     };
 
     std::vector<Core> cores;
-    std::queue<std::shared_ptr<Process>> readyQueue;
+    Core removedCores; // counters of cores dropped by setNumCores
+    std::deque<std::shared_ptr<Process>> readyQueue;
+    std::queue<std::shared_ptr<Process>> pendingQueue; // admitted in FIFO order
+    std::unique_ptr<MemoryManager> memory;
+    std::unique_ptr<Swapper> swapper;
+    int prefetchDepth = 0;
+    uint64_t tickCount = 0;
+
+    static constexpr size_t QUEUE_HISTORY = 20;
+    uint64_t queueLengthSum = 0;
+    size_t maxQueueLength = 0;
+    std::array<uint32_t, QUEUE_HISTORY> queueHistory{}; // ring, one sample per tick
+    Histogram waitTimes;
+    Histogram turnaroundTimes;
+    Histogram responseTimes;
+
+    // READY processes that are resident and hold memory, oldest dispatch first
+    std::set<std::pair<uint64_t, Process*>> swapCandidates;
+    std::set<int> failedSwapIns; // PIDs already reported, retried quietly
+
+    Tracer* tracer = nullptr; // not owned
 
     bool isRunning;
 
+    bool admit(const std::shared_ptr<Process>& process);
+    void admitPending();
+    void release(Process& process);
+    void makeReady(const std::shared_ptr<Process>& process);
+    void recordFinish(Process& process);
+    Core totalCounters() const; // all cores, including removed ones
+    static void saveCounters(BinaryWriter& out, const Core& core);
+    static bool loadCounters(BinaryReader& in, Core& core);
+    bool makeRoom(size_t size);
+    enum class Residency { RESIDENT, NO_MEMORY, SWAP_FAILED };
+    Residency makeResident(const std::shared_ptr<Process>& process);
     void assignProcessesToCores();
     void executeProcesses();
+
+    void trace(int track, Tracer::Kind kind, int pid, uint32_t value = 0) {
+        if (tracer && tracer->isEnabled()) tracer->record(track, kind, tickCount, pid, value);
+    }
 };
@@ -0,0 +1,181 @@
+#include "SelfCheck.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "BinaryIO.h"
+#include "Config.h"
+#include "Emulator.h"
+#include "MemoryManager.h"
+#include "Process.h"
+#include "ProgramParser.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (ok) return;
+    std::cout << "FAILED: " << what << "\n";
+    failures++;
+}
+
+std::shared_ptr<Process> compiled(const std::string& source, bool owned = false) {
+    std::string error;
+    auto program = ProgramParser::compile(source, error);
+    check(program != nullptr, "compile " + source + ": " + error);
+    auto process = std::make_shared<Process>(1, "check", 0);
+    if (program) process->setProgram(program, owned);
+    return process;
+}
+
+// Ticks a process on core 0 until it finishes; returns the ticks taken
+int runToEnd(Process& process, int limit = 100000) {
+    int ticks = 0;
+    for (; !process.isFinished() && ticks < limit; ++ticks) process.executeNextInstruction(0);
+    return ticks;
+}
+
+bool printed(const Process& process, const std::string& text) {
+    return process.getOutput().find(text) != std::string::npos;
+}
+
+void checkOps() {
+    auto process = compiled("DECLARE a 10; ADD b a 5; SUBTRACT c b 3; SLEEP 2; PRINT(\"c = \" + c)");
+    check(process->getLinesOfCode() == 5, "each op is one instruction");
+    int ticks = runToEnd(*process);
+    check(process->isFinished() && process->getCommandCounter() == 5, "the script runs to the end");
+    check(ticks == 7, "SLEEP 2 holds the process for two more ticks");
+    check(printed(*process, "check: c = 12"), "DECLARE, ADD, SUBTRACT and PRINT compute 10 + 5 - 3");
+
+    std::string error;
+    check(!ProgramParser::compile("DECLARE a", error), "DECLARE without a value is rejected");
+    check(!ProgramParser::compile("JUMP 3", error), "unknown ops are rejected");
+
+    auto first = ProgramCache::getInstance()->get("DECLARE a 1; PRINT(\"a = \" + a)", error);
+    auto second = ProgramCache::getInstance()->get("DECLARE a 1; PRINT(\"a = \" + a)", error);
+    check(first && first == second, "resubmitted scripts share one program");
+}
+
+void checkLoops() {
+    auto process = compiled("DECLARE n 0; FOR([ADD n n 1; FOR([ADD n n 10], 3)], 4); FOR([ADD n n 100], 0); "
+                            "PRINT(\"n = \" + n)");
+    check(process->getLinesOfCode() == 18, "loop bodies count once per repeat, empty loops not at all");
+    runToEnd(*process);
+    check(process->getCommandCounter() == 18, "nested loops run every repeat");
+    check(printed(*process, "check: n = 124"), "nested loops add 4 * (1 + 3 * 10)");
+
+    std::string error;
+    check(ProgramParser::compile("FOR([FOR([FOR([DECLARE a 1], 2)], 2)], 2)", error) != nullptr,
+          "loops nest " + std::to_string(Program::MAX_LOOP_DEPTH) + " deep");
+    check(!ProgramParser::compile("FOR([FOR([FOR([FOR([DECLARE a 1], 2)], 2)], 2)], 2)", error),
+          "loops nested deeper than " + std::to_string(Program::MAX_LOOP_DEPTH) + " are rejected");
+}
+
+// screen -ls rows by PID (their order follows the process table's hashing)
+// and vmstat as text; finish times are wall-clock, so optional
+std::string describe(const Emulator& emulator, bool withFinishTimes) {
+    auto snapshot = emulator.takeSnapshot({});
+    auto& rows = snapshot->processes;
+    std::sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) { return a.pid < b.pid; });
+    std::ostringstream out;
+    for (const auto& row : rows) {
+        out << row.name << " " << row.pid << " " << row.core << " " << row.state << " " << row.executed << "/"
+            << row.total << " " << row.finished << " " << row.swapped;
+        if (withFinishTimes) out << " " << row.finishTime;
+        out << "\n";
+    }
+    Emulator::writeVmstat(out, snapshot->vmstat);
+    return out.str();
+}
+
+void checkCheckpoint() {
+    Config config;
+    config.numCPU = 2;
+    config.schedulerAlgo = "rr";
+    config.maxOverallMem = 512; // small enough that some processes wait for memory
+    config.backingStore = "none";
+    Emulator original(config);
+    original.setSeed(1);
+    original.runTicks(300);
+
+    BinaryWriter saved;
+    check(original.save(saved), "checkpoint saves");
+    BinaryReader in(saved.data().data(), saved.data().size());
+    std::string error;
+    auto restored = Emulator::load(in, config, error);
+    check(restored != nullptr, "checkpoint loads: " + error);
+    if (!restored) return;
+    check(describe(*restored, true) == describe(original, true), "a restored checkpoint shows the same state");
+
+    BinaryWriter again;
+    restored->save(again);
+    check(again.data() == saved.data(), "saving a restored checkpoint gives the same bytes");
+
+    original.runTicks(300);
+    restored->runTicks(300);
+    check(describe(*restored, false) == describe(original, false), "a restored emulator carries on like the original");
+}
+
+void checkSwapImage() {
+    const std::string source = "DECLARE a 1; FOR([ADD a a 2; PRINT(\"a = \" + a)], 5)";
+    auto process = compiled(source, true);
+    auto twin = compiled(source);
+    for (int i = 0; i < 4; ++i) {
+        process->executeNextInstruction(0);
+        twin->executeNextInstruction(0);
+    }
+
+    BinaryWriter image;
+    process->writeSwapImage(image);
+    process->swapOut();
+    check(process->isSwapped() && !process->getProgram(), "swapping out drops an owned program");
+    BinaryReader in(image.data().data(), image.data().size());
+    check(process->swapIn(in) && !process->isSwapped(), "a swap image reads back");
+
+    BinaryWriter again;
+    process->writeSwapImage(again);
+    check(again.data() == image.data(), "swapping in restores the program, registers and output log");
+    runToEnd(*process);
+    runToEnd(*twin);
+    check(process->getCommandCounter() == twin->getCommandCounter() && printed(*process, "check: a = 11"),
+          "a swapped process carries on from the instruction it stopped at");
+}
+
+void checkBuddyAllocator() {
+    check(MemoryManager::usableSize(1000) == 512, "memory is rounded down to a power of two");
+    MemoryManager memory(1024);
+    size_t a = memory.allocate(64);
+    size_t b = memory.allocate(64);
+    size_t c = memory.allocate(100);
+    check(a == 0 && b == 64 && c == 128, "blocks are split off the low end, rounded up to powers of two");
+    check(memory.getUsedMemory() == 256 && memory.getInternalFragmentation() == 28, "used memory counts whole blocks");
+    check(memory.allocate(2048) == MemoryManager::NO_BLOCK, "requests larger than memory are refused");
+    check(memory.getLargestFreeBlock() == 512, "the upper half stays one free block");
+
+    memory.free(a);
+    check(memory.getLargestFreeBlock() == 512 && memory.getExternalFragmentation() == 320,
+          "a freed block whose buddy is in use stays apart");
+    memory.free(b);
+    check(memory.allocate(128) == 0, "freed buddies coalesce");
+    memory.free(0);
+    memory.free(c);
+    check(memory.getFreeMemory() == 1024 && memory.getLargestFreeBlock() == 1024 && memory.getAllocatedBlocks() == 0,
+          "freeing everything coalesces back to one block");
+    check(memory.allocate(1024) == 0, "the whole memory can be allocated again");
+}
+
+}
+
+int runSelfCheck() {
+    checkOps();
+    checkLoops();
+    checkCheckpoint();
+    checkSwapImage();
+    checkBuddyAllocator();
+
+    if (failures == 0) std::cout << "All self-checks passed.\n";
+    else std::cout << failures << " self-check(s) failed.\n";
+    return failures;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+// Quick checks of the parts that are easy to break without noticing: the
+// script compiler and interpreter, loops, checkpoints, swapping and the
+// buddy allocator. Run with "os_emulator.exe --self-check"; prints each
+// failed check and returns how many failed.
+int runSelfCheck();
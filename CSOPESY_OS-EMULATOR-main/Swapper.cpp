@@ -0,0 +1,235 @@
+#include "Swapper.h"
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <system_error>
+
+Swapper::Swapper(const std::string& path, bool prefetching) : path(path) {
+    file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (prefetching) {
+        prefetchFile.open(path, std::ios::binary);
+        worker = std::thread(&Swapper::prefetchLoop, this);
+    }
+}
+
+Swapper::~Swapper() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    prefetchSignal.notify_all();
+    if (worker.joinable()) worker.join();
+
+    file.close();
+    prefetchFile.close();
+    std::remove(path.c_str());
+}
+
+bool Swapper::isOpen() const {
+    return file.is_open() && (!worker.joinable() || prefetchFile.is_open());
+}
+
+bool Swapper::swapOut(Process& process) {
+    BinaryWriter out;
+    process.writeSwapImage(out);
+    const auto& image = out.data();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    Extent extent{reserve(static_cast<uint32_t>(image.size())), static_cast<uint32_t>(image.size()), nextGeneration++};
+    file.clear();
+    file.seekp(static_cast<std::streamoff>(extent.offset));
+    file.write(image.data(), image.size());
+    file.flush(); // the prefetch worker reads through its own handle
+    if (!file) {
+        releaseExtent(extent);
+        return false;
+    }
+
+    extents[process.getPID()] = extent;
+    prefetched.erase(process.getPID());
+    swapOuts++;
+    bytesOut += image.size();
+    process.swapOut();
+    return true;
+}
+
+bool Swapper::swapIn(Process& process) {
+    std::vector<char> image;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = extents.find(process.getPID());
+        if (it == extents.end()) return false;
+
+        auto hit = prefetched.find(process.getPID());
+        if (hit != prefetched.end()) {
+            image = std::move(hit->second);
+            prefetched.erase(hit);
+            prefetchHits++;
+        } else if (!readLocked(it->second, image)) {
+            return false;
+        }
+
+        releaseExtent(it->second);
+        extents.erase(it);
+        swapIns++;
+        bytesIn += image.size();
+    }
+
+    BinaryReader in(image.data(), image.size());
+    return process.swapIn(in);
+}
+
+void Swapper::prefetch(const Process& process) {
+    if (!worker.joinable()) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    int pid = process.getPID();
+    if (!extents.count(pid) || prefetched.count(pid)) return;
+    for (int queued : prefetchQueue) {
+        if (queued == pid) return;
+    }
+    prefetchQueue.push_back(pid);
+    prefetchSignal.notify_one();
+}
+
+bool Swapper::readImage(int pid, std::vector<char>& image) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto hit = prefetched.find(pid);
+    if (hit != prefetched.end()) {
+        image = hit->second;
+        return true;
+    }
+    auto it = extents.find(pid);
+    return it != extents.end() && readLocked(it->second, image);
+}
+
+bool Swapper::readLocked(const Extent& extent, std::vector<char>& image) {
+    image.resize(extent.length);
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(extent.offset));
+    file.read(image.data(), extent.length);
+    return static_cast<bool>(file);
+}
+
+uint64_t Swapper::reserve(uint32_t length) {
+    auto fit = freeBySize.lower_bound(length);
+    if (fit == freeBySize.end()) {
+        uint64_t offset = fileEnd;
+        fileEnd += length;
+        return offset;
+    }
+
+    uint64_t offset = fit->second;
+    uint64_t spare = fit->first - length;
+    forgetFree(freeByOffset.find(offset));
+    // The rest cannot touch another free extent: free neighbours are always merged
+    if (spare > 0) {
+        freeBySize.emplace(spare, offset + length);
+        freeByOffset.emplace(offset + length, spare);
+    }
+    return offset;
+}
+
+void Swapper::releaseExtent(const Extent& extent) {
+    uint64_t offset = extent.offset;
+    uint64_t length = extent.length;
+    if (length == 0) return;
+
+    auto next = freeByOffset.lower_bound(offset);
+    if (next != freeByOffset.end() && next->first == offset + length) {
+        length += next->second;
+        forgetFree(next);
+    }
+    next = freeByOffset.lower_bound(offset);
+    if (next != freeByOffset.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            length += previous->second;
+            forgetFree(previous);
+        }
+    }
+
+    if (offset + length == fileEnd) {
+        // Best effort: if the file cannot shrink, later writes still reuse the space
+        fileEnd = offset;
+        std::error_code error;
+        std::filesystem::resize_file(path, fileEnd, error);
+        return;
+    }
+    freeBySize.emplace(length, offset);
+    freeByOffset.emplace(offset, length);
+}
+
+void Swapper::forgetFree(std::map<uint64_t, uint64_t>::iterator free) {
+    auto sized = freeBySize.equal_range(free->second);
+    for (auto it = sized.first; it != sized.second; ++it) {
+        if (it->second == free->first) {
+            freeBySize.erase(it);
+            break;
+        }
+    }
+    freeByOffset.erase(free);
+}
+
+void Swapper::prefetchLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        prefetchSignal.wait(lock, [this] { return stopping || !prefetchQueue.empty(); });
+        if (stopping) return;
+
+        int pid = prefetchQueue.front();
+        prefetchQueue.pop_front();
+        auto it = extents.find(pid);
+        if (it == extents.end() || prefetched.count(pid)) continue;
+        Extent extent = it->second;
+
+        // Read without the lock so the scheduler thread is never held up by disk
+        lock.unlock();
+        std::vector<char> image(extent.length);
+        prefetchFile.clear();
+        prefetchFile.seekg(static_cast<std::streamoff>(extent.offset));
+        bool ok = static_cast<bool>(prefetchFile.read(image.data(), extent.length));
+        lock.lock();
+
+        // Keep it only if the process was not swapped in (or out again) meanwhile
+        auto current = extents.find(pid);
+        if (ok && current != extents.end() && current->second.generation == extent.generation) {
+            prefetched[pid] = std::move(image);
+        }
+    }
+}
+
+uint64_t Swapper::getSwapOuts() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return swapOuts;
+}
+
+uint64_t Swapper::getSwapIns() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return swapIns;
+}
+
+uint64_t Swapper::getBytesOut() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytesOut;
+}
+
+uint64_t Swapper::getBytesIn() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytesIn;
+}
+
+uint64_t Swapper::getPrefetchHits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return prefetchHits;
+}
+
+size_t Swapper::getSwappedCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return extents.size();
+}
+
+uint64_t Swapper::getFileSize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return fileEnd;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include "Process.h"
+
+// Moves whole processes to a backing-store file and back. Freed extents of
+// the file are merged with free neighbours and reused best-fit; free space
+// at the end of the file is truncated away. A worker thread prefetches
+// images of processes that are about to be dispatched so swapIn() rarely
+// touches disk; without prefetching there is no worker and prefetch() does
+// nothing.
+class Swapper {
+public:
+    explicit Swapper(const std::string& path, bool prefetching = true);
+    ~Swapper(); // removes the backing store
+    Swapper(const Swapper&) = delete;
+    Swapper& operator=(const Swapper&) = delete;
+
+    bool isOpen() const;
+
+    bool swapOut(Process& process);
+    bool swapIn(Process& process);
+    void prefetch(const Process& process);
+
+    // Copy of a swapped process's image, for checkpoints
+    bool readImage(int pid, std::vector<char>& image);
+
+    uint64_t getSwapOuts() const;
+    uint64_t getSwapIns() const;
+    uint64_t getBytesOut() const;
+    uint64_t getBytesIn() const;
+    uint64_t getPrefetchHits() const;
+    size_t getSwappedCount() const;
+    uint64_t getFileSize() const;
+
+private:
+    struct Extent {
+        uint64_t offset;
+        uint32_t length;
+        uint64_t generation; // changes on every swap-out, detects stale prefetches
+    };
+
+    std::string path;
+    std::fstream file;      // used by the scheduler thread
+    std::ifstream prefetchFile; // used by the prefetch worker only
+
+    mutable std::mutex mutex; // guards everything below
+    std::unordered_map<int, Extent> extents;
+    std::multimap<uint64_t, uint64_t> freeBySize;  // length -> offset
+    std::map<uint64_t, uint64_t> freeByOffset;     // offset -> length, for merging
+    uint64_t fileEnd = 0;
+    uint64_t nextGeneration = 0;
+    std::unordered_map<int, std::vector<char>> prefetched;
+    std::deque<int> prefetchQueue;
+    std::condition_variable prefetchSignal;
+    bool stopping = false;
+    std::thread worker;
+
+    uint64_t swapOuts = 0;
+    uint64_t swapIns = 0;
+    uint64_t bytesOut = 0;
+    uint64_t bytesIn = 0;
+    uint64_t prefetchHits = 0;
+
+    uint64_t reserve(uint32_t length);
+    void releaseExtent(const Extent& extent);
+    void forgetFree(std::map<uint64_t, uint64_t>::iterator free);
+    bool readLocked(const Extent& extent, std::vector<char>& image);
+    void prefetchLoop();
+};
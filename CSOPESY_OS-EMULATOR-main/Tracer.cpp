@@ -0,0 +1,117 @@
+#include "Tracer.h"
+#include <fstream>
+#include <algorithm>
+
+Tracer::Tracer(int cores, size_t capacity) {
+    size_t size = ringSize(capacity);
+    mask = size - 1;
+    for (int i = 0; i <= cores; ++i) {
+        rings.push_back(std::make_unique<Ring>(size));
+    }
+}
+
+size_t Tracer::ringSize(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    return size;
+}
+
+void Tracer::record(int track, Kind kind, uint64_t tick, int pid, uint32_t value) {
+    if (track < 0 || track >= static_cast<int>(rings.size())) {
+        droppedTracks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Ring& ring = *rings[track];
+    size_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail - ring.head.load(std::memory_order_acquire) > mask) {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring.slots[tail & mask] = Event{tick, pid, value, static_cast<uint16_t>(track), kind};
+    ring.tail.store(tail + 1, std::memory_order_release);
+}
+
+void Tracer::drain(std::vector<Event>& events) {
+    for (auto& ring : rings) {
+        size_t head = ring->head.load(std::memory_order_relaxed);
+        size_t tail = ring->tail.load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            events.push_back(ring->slots[head & mask]);
+        }
+        ring->head.store(head, std::memory_order_release);
+    }
+}
+
+uint64_t Tracer::getDropped() const {
+    uint64_t total = droppedTracks.load(std::memory_order_relaxed);
+    for (const auto& ring : rings) {
+        total += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+namespace {
+
+void writeString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+bool Tracer::writeJson(const std::string& path, int cores, const std::vector<Event>& events,
+                       const std::function<std::string(int)>& nameOf) {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+
+    // Chrome wants begin/end pairs of a track in time order
+    std::vector<Event> sorted(events);
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     [](const Event& a, const Event& b) { return a.tick < b.tick; });
+
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CSOPESY scheduler\"}}";
+    for (int i = 0; i < cores; ++i) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+            << ",\"args\":{\"name\":\"Core " << i << "\"}}";
+    }
+
+    for (const auto& event : sorted) {
+        out << ",\n{";
+        switch (event.kind) {
+            case DISPATCH:
+                out << "\"name\":";
+                writeString(out, nameOf(event.pid));
+                out << ",\"ph\":\"B\"";
+                break;
+            case PREEMPT:
+            case MIGRATE:
+            case FINISH:
+                out << "\"ph\":\"E\",\"args\":{\"pid\":" << event.pid << ",\"reason\":\""
+                    << (event.kind == PREEMPT ? "preempt" : event.kind == MIGRATE ? "core removed" : "finished")
+                    << "\"}";
+                break;
+            case SLEEP:
+                out << "\"name\":\"sleep\",\"ph\":\"i\",\"s\":\"t\",\"args\":{\"ticks\":" << event.value << "}";
+                break;
+            case QUEUE_DEPTH:
+                out << "\"name\":\"ready queue\",\"ph\":\"C\",\"args\":{\"processes\":" << event.value << "}";
+                break;
+        }
+        out << ",\"ts\":" << event.tick << ",\"pid\":1";
+        if (event.kind != QUEUE_DEPTH) out << ",\"tid\":" << event.track;
+        out << "}";
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
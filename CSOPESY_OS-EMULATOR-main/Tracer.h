@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Records scheduling events into one lock-free single-producer ring per
+// simulated core (plus one for scheduler-wide events) and writes them as
+// Chrome/Perfetto trace JSON. The tick thread produces, the thread calling
+// drain() consumes. A full ring drops the event instead of blocking, and a
+// disabled tracer costs one relaxed atomic load per event site.
+class Tracer {
+public:
+    enum Kind : uint8_t {
+        DISPATCH, // process starts running on the core
+        PREEMPT,  // round-robin quantum expired
+        MIGRATE,  // core removed by set-cpu
+        SLEEP,    // process executed SLEEP, value = ticks
+        FINISH,
+        QUEUE_DEPTH // value = ready queue length
+    };
+
+    struct Event {
+        uint64_t tick;
+        int32_t pid;
+        uint32_t value;
+        uint16_t track; // core, or the scheduler track
+        Kind kind;
+    };
+
+    // Tracks 0..cores-1 are cores, track `cores` is the scheduler itself.
+    // capacity is per track and rounded up to a power of two.
+    Tracer(int cores, size_t capacity);
+    static size_t ringSize(size_t capacity); // capacity rounded up
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+
+    int getCoreTracks() const { return static_cast<int>(rings.size()) - 1; }
+    int schedulerTrack() const { return getCoreTracks(); }
+
+    // Producer side. Events on tracks that do not exist (cores added by
+    // set-cpu after tracing started) are dropped.
+    void record(int track, Kind kind, uint64_t tick, int pid, uint32_t value = 0);
+
+    // Consumer side: moves every buffered event into `events`
+    void drain(std::vector<Event>& events);
+    uint64_t getDropped() const;
+
+    // Writes events as trace JSON, one thread track per core. 1 tick is
+    // shown as 1 µs. nameOf maps a PID to its process name.
+    static bool writeJson(const std::string& path, int cores, const std::vector<Event>& events,
+                          const std::function<std::string(int)>& nameOf);
+
+private:
+    struct Ring {
+        explicit Ring(size_t capacity) : slots(capacity) {}
+        std::vector<Event> slots;
+        alignas(64) std::atomic<size_t> tail{0}; // written by the producer
+        alignas(64) std::atomic<size_t> head{0}; // written by the consumer
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    std::atomic<bool> enabled{false};
+    size_t mask;
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::atomic<uint64_t> droppedTracks{0};
+};
@@ -0,0 +1,149 @@
+#include "Workload.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+const uint16_t variableCount = 3;
+const char* const variableNames[variableCount] = {"x", "y", "z"};
+
+void readDistribution(std::istream& in, Workload::Distribution& distribution) {
+    std::string name;
+    in >> name;
+    if (name == "uniform") distribution = Workload::UNIFORM;
+    else if (name == "exponential") distribution = Workload::EXPONENTIAL;
+    else std::cout << "Unknown distribution \"" << name << "\", expected uniform or exponential.\n";
+}
+
+const char* distributionName(Workload::Distribution distribution) {
+    return distribution == Workload::EXPONENTIAL ? "exponential" : "uniform";
+}
+
+} // namespace
+
+bool Workload::readKey(const std::string& key, std::istream& in) {
+    if (key == "seed") in >> seed;
+    else if (key == "mix-print") in >> mix[PRINT];
+    else if (key == "mix-declare") in >> mix[DECLARE];
+    else if (key == "mix-add") in >> mix[ADD];
+    else if (key == "mix-subtract") in >> mix[SUBTRACT];
+    else if (key == "mix-sleep") in >> mix[SLEEP];
+    else if (key == "sleep-dist") readDistribution(in, sleepDistribution);
+    else if (key == "sleep-min") in >> sleepMin;
+    else if (key == "sleep-max") in >> sleepMax;
+    else if (key == "sleep-mean") in >> sleepMean;
+    else if (key == "length-dist") readDistribution(in, lengthDistribution);
+    else if (key == "length-mean") in >> lengthMean;
+    else return false;
+    return true;
+}
+
+void Workload::validate() {
+    uint32_t total = 0;
+    for (uint32_t weight : mix) total += weight;
+    if (total == 0) {
+        std::cout << "All mix weights are 0, using the default DECLARE/ADD/SUBTRACT/PRINT mix.\n";
+        mix = {{1, 1, 1, 1, 0}};
+    }
+
+    int low = std::clamp(sleepMin, 1, MAX_SLEEP);
+    int high = std::clamp(sleepMax, low, MAX_SLEEP);
+    if (low != sleepMin || high != sleepMax) {
+        std::cout << "Sleep range " << sleepMin << "-" << sleepMax << " adjusted to " << low << "-" << high << " ticks.\n";
+        sleepMin = low;
+        sleepMax = high;
+    }
+    if (sleepMean <= sleepMin) sleepMean = (sleepMin + sleepMax) / 2.0 + 0.5;
+    if (lengthMean < 0) lengthMean = 0;
+}
+
+uint64_t Workload::getSeed() const {
+    return seed;
+}
+
+std::string Workload::describe() const {
+    std::ostringstream out;
+    out << "Mix PRINT/DECLARE/ADD/SUBTRACT/SLEEP = " << mix[PRINT] << "/" << mix[DECLARE] << "/" << mix[ADD] << "/"
+        << mix[SUBTRACT] << "/" << mix[SLEEP] << ", Sleep = " << distributionName(sleepDistribution) << " "
+        << sleepMin << "-" << sleepMax << " ticks, Length = " << distributionName(lengthDistribution);
+    return out.str();
+}
+
+int Workload::instructionCount(Rng& rng, int minInstructions, int maxInstructions) const {
+    if (maxInstructions <= minInstructions) return minInstructions;
+    if (lengthDistribution == UNIFORM) return rng.between(minInstructions, maxInstructions);
+
+    // Exponential tail above min-ins, cut off at max-ins
+    double mean = lengthMean > minInstructions ? lengthMean : (static_cast<double>(minInstructions) + maxInstructions) / 2;
+    double length = minInstructions + rng.exponential(mean - minInstructions);
+    return length >= maxInstructions ? maxInstructions : static_cast<int>(length);
+}
+
+Op Workload::randomOp(Rng& rng, uint32_t totalWeight, uint16_t message) const {
+    uint32_t pick = rng.below(totalWeight);
+    int kind = 0;
+    while (pick >= mix[kind]) pick -= mix[kind++];
+
+    uint16_t dst = static_cast<uint16_t>(rng.below(variableCount));
+    switch (kind) {
+        case PRINT:
+            return {OpCode::PRINT, 0, 0, message, 0};
+        case DECLARE:
+            return {OpCode::DECLARE, Program::A_LITERAL, dst, static_cast<uint16_t>(rng.below(100)), 0};
+        case ADD:
+        case SUBTRACT: {
+            OpCode code = kind == ADD ? OpCode::ADD : OpCode::SUBTRACT;
+            uint16_t a = static_cast<uint16_t>(rng.below(variableCount));
+            // Half the time the second operand is a literal
+            if (rng.below(2)) return {code, Program::B_LITERAL, dst, a, static_cast<uint16_t>(rng.between(1, 10))};
+            return {code, 0, dst, a, static_cast<uint16_t>(rng.below(variableCount))};
+        }
+        default: {
+            double ticks = sleepDistribution == UNIFORM ? rng.between(sleepMin, sleepMax)
+                                                        : sleepMin + rng.exponential(sleepMean - sleepMin);
+            int clamped = std::clamp(static_cast<int>(ticks), sleepMin, sleepMax);
+            return {OpCode::SLEEP, Program::A_LITERAL, 0, static_cast<uint16_t>(clamped), 0};
+        }
+    }
+}
+
+std::shared_ptr<Program> Workload::generate(Rng& rng, int instructionCount) const {
+    auto program = std::make_shared<Program>();
+    for (const char* name : variableNames) program->symbol(name);
+    uint16_t message = program->addString("Instruction executed.");
+    uint32_t totalWeight = 0;
+    for (uint32_t weight : mix) totalWeight += weight;
+
+    int bodySize = std::min(instructionCount, BODY_OPS);
+    int blocks = bodySize > 0 ? instructionCount / bodySize : 0;
+    if (blocks > 1) {
+        // The blocks are shared out over the loops as evenly as possible
+        int loops = std::min(blocks, LOOPS);
+        std::vector<std::vector<Op>> bodies(std::min(loops, BODIES));
+        for (auto& body : bodies) {
+            body.reserve(bodySize);
+            for (int i = 0; i < bodySize; ++i) body.push_back(randomOp(rng, totalWeight, message));
+        }
+        for (int loop = 0; loop < loops; ++loop) {
+            const auto& body = bodies[rng.below(static_cast<uint32_t>(bodies.size()))];
+            // FOR counts are 16-bit, so huge shares take several loops
+            int share = blocks / loops + (loop < blocks % loops ? 1 : 0);
+            while (share > 0) {
+                uint16_t repeats = static_cast<uint16_t>(std::min(share, 0xFFFF));
+                uint16_t start = static_cast<uint16_t>(program->code.size() + 1);
+                program->code.push_back({OpCode::FOR_BEGIN, Program::A_LITERAL, 0, repeats,
+                                         static_cast<uint16_t>(start + bodySize + 1)});
+                program->code.insert(program->code.end(), body.begin(), body.end());
+                program->code.push_back({OpCode::LOOP_END, 0, 0, start, 0});
+                share -= repeats;
+            }
+        }
+        instructionCount %= bodySize;
+    }
+    for (int i = 0; i < instructionCount; ++i) program->code.push_back(randomOp(rng, totalWeight, message));
+
+    program->finalize();
+    return program;
+}
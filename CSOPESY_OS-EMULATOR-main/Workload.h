@@ -0,0 +1,48 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include "Program.h"
+#include "Rng.h"
+
+// Shape of the generated dummy processes, set from config.txt: how often
+// each instruction appears, how long SLEEPs last and how program lengths
+// are spread between min-ins and max-ins. Generation is O(1) in the
+// instruction count: up to BODIES random bodies of BODY_OPS instructions
+// each are repeated with at most LOOPS FOR loops, each loop running one
+// body picked at random.
+class Workload {
+public:
+    enum Distribution { UNIFORM, EXPONENTIAL };
+
+    static constexpr int BODY_OPS = 64;
+    static constexpr int BODIES = 4;
+    static constexpr int LOOPS = 8;
+    static constexpr int MAX_SLEEP = 255; // SLEEP takes an 8-bit tick count
+
+    // Reads the value of a workload key; false if key is not one
+    bool readKey(const std::string& key, std::istream& in);
+    void validate(); // puts out-of-range settings back in range, with a message
+
+    uint64_t getSeed() const; // 0 asks for a random seed
+    std::string describe() const;
+
+    int instructionCount(Rng& rng, int minInstructions, int maxInstructions) const;
+    std::shared_ptr<Program> generate(Rng& rng, int instructionCount) const;
+
+private:
+    enum Kind { PRINT, DECLARE, ADD, SUBTRACT, SLEEP, KINDS };
+
+    std::array<uint32_t, KINDS> mix{{1, 1, 1, 1, 0}}; // relative weights
+    Distribution sleepDistribution = UNIFORM;
+    int sleepMin = 1;
+    int sleepMax = 10;
+    double sleepMean = 5;
+    Distribution lengthDistribution = UNIFORM;
+    double lengthMean = 0; // 0 = halfway between min-ins and max-ins
+    uint64_t seed = 0;
+
+    Op randomOp(Rng& rng, uint32_t totalWeight, uint16_t message) const;
+};
@@ -1,6 +1,11 @@
 #include "ConsoleManager.h"
+#include "SelfCheck.h"
+#include <cstring>
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "--self-check") == 0) {
+        return runSelfCheck() == 0 ? 0 : 1;
+    }
     ConsoleManager::getInstance()->run();
     return 0;
 }
\ No newline at end of file